@@ -0,0 +1,487 @@
+// Propagation microbenchmark: replays sequences of decisions against a
+// solver and measures decide, unit_prop and backjump apart from
+// conflict analysis, heuristics and clause database management. Reports
+// propagations per second, the bytes of solver data read per propagation
+// and, where perf_event_open is available, cache misses per propagation.
+//
+//   nimmersat_propagation [--workload=random3|long|binary|all] [--cnf=FILE]
+//                         [--decisions=FILE] [--record=FILE] [--scale=F]
+//                         [--rounds=N] [--seed=N]
+//
+// Without --decisions every round decides all variables in a random order
+// with random polarity. A round ends at its first conflict or once all
+// variables are assigned, and every round starts from level 0. Decision
+// files hold DIMACS literals with every round terminated by 0, as written
+// by --record, so that the same sequence can be replayed after changing
+// the generator or the solver.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Dimacs/Dimacs.h"
+#include "Solver/Assign.h"
+
+namespace NimmerSAT {
+
+// The variant the default options are solved with.
+using BenchmarkSolver = BasicSolver<DefaultPolicy>;
+
+class PropagationBenchmark final {
+public:
+
+    struct Result {
+        std::uint64_t decisions = 0;
+        std::uint64_t conflicts = 0;
+        std::uint64_t propagations = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    explicit PropagationBenchmark(BenchmarkSolver& solver) : solver(solver) {
+    }
+
+    // Level 0 units of the formula, false if they are contradictory.
+    bool prepare() {
+        return solver.unit_prop();
+    }
+
+    // With Count the bytes read by every propagate are added up before it
+    // runs. This stepping is slower than unit_prop and is
+    // therefore kept out of the timed replay.
+    template <bool Count>
+    Result replay(const std::vector<std::vector<LitId>>& rounds) {
+        Result result;
+        for (const auto &decisions : rounds) {
+            for (LitId lit : decisions) {
+                if (solver.variables.lit_val(lit) != Value::UNASSIGNED) {
+                    continue;
+                }
+                std::size_t start = solver.trail.size();
+                solver.decide(lit);
+                bool consistent;
+                if constexpr (Count) {
+                    consistent = propagate_counting(result.bytes);
+                } else {
+                    consistent = solver.unit_prop();
+                }
+                result.decisions++;
+                result.propagations += solver.trail.size() - start;
+                if (!consistent) {
+                    result.conflicts++;
+                    break;
+                }
+            }
+            solver.backjump(0);
+        }
+        return result;
+    }
+
+private:
+
+    // Same steps as unit_prop.
+    bool propagate_counting(std::uint64_t& bytes) {
+        while (solver.trail.pending()) {
+            LitId lit = solver.trail.next();
+            bytes += touched(lit);
+            if (!solver.propagate(lit)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Bytes assigning and propagating lit reads or writes in the
+    // current state: the assignment itself, the binary implications, the
+    // watchers of the negation and the clause words and values behind
+    // them. Watchers after a conflict are counted as if visited.
+    std::uint64_t touched(LitId lit) const {
+        const VariableCache &variables = solver.variables;
+        std::uint64_t bytes = 2 * sizeof(Value) + sizeof(std::uint32_t) + sizeof(ClauseId) +
+            2 * sizeof(LitId);
+
+        bytes += variables.binaries(lit).size() * (sizeof(LitId) + sizeof(Value));
+
+        LitId false_lit = Neg(lit);
+        for (const Watcher &watcher : variables.watches(false_lit)) {
+            bytes += sizeof(Watcher) + sizeof(Value);
+            if (variables.lit_val(watcher.blocker) == Value::TRUE) {
+                continue;
+            }
+            const Clause clause = solver.clauses[watcher.clause];
+            LitId first = clause[0] == false_lit ? clause[1] : clause[0];
+            bytes += 2 * sizeof(LitId);
+            if (first != watcher.blocker) {
+                bytes += sizeof(Value);
+                if (variables.lit_val(first) == Value::TRUE) {
+                    continue;
+                }
+            }
+            bytes += sizeof(LitId);
+            for (std::uint32_t k = 2; k < clause.size(); k++) {
+                bytes += sizeof(LitId) + sizeof(Value);
+                if (variables.lit_val(clause[k]) != Value::FALSE) {
+                    bytes += sizeof(Watcher);
+                    break;
+                }
+            }
+        }
+        return bytes;
+    }
+
+    BenchmarkSolver &solver;
+
+};
+
+}  // namespace NimmerSAT
+
+namespace {
+
+using namespace NimmerSAT;
+
+// Hardware cache miss counters of the calling thread, unavailable when the
+// kernel or the sandbox does not allow perf_event_open.
+class CacheCounters final {
+public:
+
+    CacheCounters() {
+#ifdef __linux__
+        constexpr std::uint64_t L1D_READ_MISS = PERF_COUNT_HW_CACHE_L1D |
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        descriptors[L1D] = open(PERF_TYPE_HW_CACHE, L1D_READ_MISS);
+        descriptors[LLC] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+    }
+
+    CacheCounters(const CacheCounters&) = delete;
+    CacheCounters& operator=(const CacheCounters&) = delete;
+
+    ~CacheCounters() {
+#ifdef __linux__
+        for (int descriptor : descriptors) {
+            if (descriptor >= 0) {
+                close(descriptor);
+            }
+        }
+#endif
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int descriptor : descriptors) {
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int descriptor : descriptors) {
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    std::optional<std::uint64_t> l1d_misses() const {
+        return read_counter(L1D);
+    }
+
+    std::optional<std::uint64_t> llc_misses() const {
+        return read_counter(LLC);
+    }
+
+private:
+
+    enum Counter {
+        L1D = 0,
+        LLC = 1
+    };
+
+#ifdef __linux__
+    static int open(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.type = type;
+        attributes.size = sizeof(attributes);
+        attributes.config = config;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    }
+#endif
+
+    std::optional<std::uint64_t> read_counter(Counter counter) const {
+#ifdef __linux__
+        std::uint64_t value;
+        if (descriptors[counter] >= 0 &&
+            read(descriptors[counter], &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value))) {
+            return value;
+        }
+#endif
+        static_cast<void>(counter);
+        return std::nullopt;
+    }
+
+    int descriptors[2] = {-1, -1};
+
+};
+
+struct Workload {
+    std::string name;
+    std::uint32_t variable_count = 0;
+    ClauseCache clauses;
+};
+
+// Adds count clauses of the given length over distinct random variables.
+void AddRandomClauses(ClauseCache& clauses, std::uint32_t variable_count, std::size_t count,
+                      std::uint32_t min_length, std::uint32_t max_length, std::mt19937_64& random) {
+    std::uniform_int_distribution<VarId> variable(1, variable_count);
+    std::uniform_int_distribution<std::uint32_t> length(min_length, max_length);
+    std::bernoulli_distribution positive;
+    std::vector<LitId> clause;
+    for (std::size_t i = 0; i < count; i++) {
+        clause.clear();
+        for (std::uint32_t size = length(random); clause.size() < size;) {
+            VarId var = variable(random);
+            if (std::none_of(clause.begin(), clause.end(), [&](LitId lit) { return LitToVar(lit) == var; })) {
+                clause.push_back(VarToLit(var, positive(random)));
+            }
+        }
+        clauses.add(clause);
+    }
+}
+
+// Random 3-SAT just below the threshold, long clauses that rarely become
+// unit but have to be scanned for replacement watches, and a mostly binary
+// formula whose implications dominate.
+Workload Generate(std::string_view name, double scale, std::mt19937_64& random) {
+    Workload workload;
+    workload.name = name;
+    auto scaled = [&](double count) {
+        return static_cast<std::size_t>(std::max(1.0, count * scale));
+    };
+    if (name == "random3") {
+        workload.variable_count = static_cast<std::uint32_t>(scaled(200000));
+        AddRandomClauses(workload.clauses, workload.variable_count, scaled(800000), 3, 3, random);
+    } else if (name == "long") {
+        workload.variable_count = static_cast<std::uint32_t>(scaled(50000));
+        AddRandomClauses(workload.clauses, workload.variable_count, scaled(200000), 12, 32, random);
+    } else if (name == "binary") {
+        workload.variable_count = static_cast<std::uint32_t>(scaled(200000));
+        AddRandomClauses(workload.clauses, workload.variable_count, scaled(160000), 2, 2, random);
+        AddRandomClauses(workload.clauses, workload.variable_count, scaled(400000), 3, 3, random);
+    }
+    return workload;
+}
+
+std::vector<std::vector<LitId>> RandomDecisions(std::uint32_t variable_count, std::uint32_t rounds,
+                                                std::mt19937_64& random) {
+    std::vector<std::vector<LitId>> decisions(rounds);
+    std::bernoulli_distribution positive;
+    for (auto &round : decisions) {
+        round.reserve(variable_count);
+        for (VarId var = 1; var <= variable_count; var++) {
+            round.push_back(VarToLit(var, positive(random)));
+        }
+        std::shuffle(round.begin(), round.end(), random);
+    }
+    return decisions;
+}
+
+std::optional<std::vector<std::vector<LitId>>> ReadDecisions(const char* path, std::uint32_t variable_count) {
+    std::ifstream file(path);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::vector<std::vector<LitId>> decisions(1);
+    std::int64_t dimacs;
+    while (file >> dimacs) {
+        if (dimacs == 0) {
+            decisions.emplace_back();
+            continue;
+        }
+        if (static_cast<std::uint64_t>(std::abs(dimacs)) > variable_count) {
+            return std::nullopt;
+        }
+        decisions.back().push_back(DimacsToLit(static_cast<std::int32_t>(dimacs)));
+    }
+    if (decisions.back().empty()) {
+        decisions.pop_back();
+    }
+    return decisions;
+}
+
+bool WriteDecisions(const char* path, const std::vector<std::vector<LitId>>& decisions) {
+    std::ofstream file(path);
+    for (const auto &round : decisions) {
+        for (LitId lit : round) {
+            file << LitToDimacs(lit) << ' ';
+        }
+        file << "0\n";
+    }
+    return static_cast<bool>(file);
+}
+
+struct BenchmarkOptions {
+    std::vector<std::string> workloads{"random3", "long", "binary"};
+    const char* cnf = nullptr;
+    const char* decisions = nullptr;
+    const char* record = nullptr;
+    double scale = 1.0;
+    std::uint32_t rounds = 50;
+    std::uint64_t seed = 1;
+};
+
+void PrintHeader() {
+    std::cout << std::left << std::setw(12) << "workload" << std::right
+              << std::setw(10) << "vars" << std::setw(10) << "clauses"
+              << std::setw(11) << "decisions" << std::setw(11) << "conflicts"
+              << std::setw(12) << "props" << std::setw(10) << "Mprops/s"
+              << std::setw(12) << "bytes/prop" << std::setw(12) << "L1D/prop"
+              << std::setw(12) << "LLC/prop" << std::endl;
+}
+
+void PrintPerPropagation(std::optional<std::uint64_t> count, std::uint64_t propagations) {
+    std::cout << std::setw(12);
+    if (count && propagations > 0) {
+        std::cout << static_cast<double>(*count) / static_cast<double>(propagations);
+    } else {
+        std::cout << "n/a";
+    }
+}
+
+bool Measure(Workload workload, const BenchmarkOptions& options, std::mt19937_64& random) {
+    std::size_t clause_count = workload.clauses.size();
+
+    std::vector<std::vector<LitId>> decisions;
+    if (options.decisions != nullptr) {
+        auto recorded = ReadDecisions(options.decisions, workload.variable_count);
+        if (!recorded) {
+            std::cerr << "Cannot read decisions for " << workload.name << " from " << options.decisions << std::endl;
+            return false;
+        }
+        decisions = std::move(*recorded);
+    } else {
+        decisions = RandomDecisions(workload.variable_count, options.rounds, random);
+    }
+    if (options.record != nullptr && !WriteDecisions(options.record, decisions)) {
+        std::cerr << "Cannot write decisions to " << options.record << std::endl;
+        return false;
+    }
+
+    // Both replays run on the same solver. Undoing every assignment
+    // restores the values, but watches move and phases are saved, so the
+    // counting replay also serves as warm up for the timed one.
+    BenchmarkSolver solver(workload.variable_count, std::move(workload.clauses));
+    PropagationBenchmark benchmark(solver);
+    if (!benchmark.prepare()) {
+        std::cerr << workload.name << " is refuted by its units" << std::endl;
+        return false;
+    }
+    auto counted = benchmark.replay<true>(decisions);
+
+    CacheCounters counters;
+    auto start = std::chrono::steady_clock::now();
+    counters.start();
+    auto timed = benchmark.replay<false>(decisions);
+    counters.stop();
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::left << std::setw(12) << workload.name << std::right
+              << std::setw(10) << workload.variable_count << std::setw(10) << clause_count
+              << std::setw(11) << timed.decisions << std::setw(11) << timed.conflicts
+              << std::setw(12) << timed.propagations
+              << std::setw(10) << std::fixed << std::setprecision(2)
+              << static_cast<double>(timed.propagations) / seconds.count() / 1e6;
+    PrintPerPropagation(counted.bytes, counted.propagations);
+    PrintPerPropagation(counters.l1d_misses(), timed.propagations);
+    PrintPerPropagation(counters.llc_misses(), timed.propagations);
+    std::cout << std::endl;
+    return true;
+}
+
+int Usage() {
+    std::cerr << "Usage: nimmersat_propagation [--workload=random3|long|binary|all] [--cnf=FILE]\n"
+                 "                             [--decisions=FILE] [--record=FILE] [--scale=F]\n"
+                 "                             [--rounds=N] [--seed=N]" << std::endl;
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg(argv[i]);
+        const char* value = argv[i] + arg.find('=') + 1;
+        if (arg.starts_with("--workload=")) {
+            if (std::string_view(value) != "all") {
+                options.workloads = {value};
+            }
+        } else if (arg.starts_with("--cnf=")) {
+            options.cnf = value;
+        } else if (arg.starts_with("--decisions=")) {
+            options.decisions = value;
+        } else if (arg.starts_with("--record=")) {
+            options.record = value;
+        } else if (arg.starts_with("--scale=")) {
+            options.scale = std::strtod(value, nullptr);
+        } else if (arg.starts_with("--rounds=")) {
+            options.rounds = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg.starts_with("--seed=")) {
+            options.seed = std::strtoull(value, nullptr, 10);
+        } else {
+            return Usage();
+        }
+    }
+    for (const auto &name : options.workloads) {
+        if (name != "random3" && name != "long" && name != "binary") {
+            return Usage();
+        }
+    }
+    // A recorded sequence belongs to a single formula.
+    if ((options.decisions != nullptr || options.record != nullptr) &&
+        options.cnf == nullptr && options.workloads.size() != 1) {
+        return Usage();
+    }
+
+    std::mt19937_64 random(options.seed);
+    PrintHeader();
+    if (options.cnf != nullptr) {
+        DimacsResult formula = ReadDimacsFromFile(options.cnf);
+        if (!formula.error.empty()) {
+            std::cerr << formula.error << std::endl;
+            return 1;
+        }
+        Workload workload{options.cnf, formula.variable_count, std::move(formula.clauses)};
+        return Measure(std::move(workload), options, random) ? 0 : 1;
+    }
+    for (const auto &name : options.workloads) {
+        if (!Measure(Generate(name, options.scale, random), options, random)) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,599 @@
+
+// Benchmark runner: solves every instance of a directory with NimmerSAT
+// under time and memory limits, checks the answers and reports solved
+// counts and the PAR-2 score as JSON. Two such reports can be compared to
+// spot regressions.
+//
+//   nimmersat_bench run --solver=PATH --dir=DIR [--timeout=SECONDS]
+//                       [--memory=MB] [--jobs=N] [--output=FILE] [-- ARGS]
+//   nimmersat_bench diff OLD.json NEW.json [--tolerance=PERCENT]
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Dimacs/Dimacs.h"
+
+namespace {
+
+enum class Status {
+    SAT,
+    UNSAT,
+    UNKNOWN,   // The solver gave up by itself, e.g. on its own budget
+    TIMEOUT,
+    MEMOUT,
+    ERROR,     // Crash, unexpected exit status or unparsable output
+    WRONG      // The model does not satisfy the formula
+};
+
+constexpr std::string_view STATUS_NAMES[] = {"SAT", "UNSAT", "UNKNOWN", "TIMEOUT", "MEMOUT", "ERROR", "WRONG"};
+
+struct Result {
+    std::string name;
+    Status status = Status::ERROR;
+    double seconds = 0.0;
+    long memory_kb = 0;
+};
+
+struct RunOptions {
+    std::string solver;
+    std::string directory;
+    std::vector<std::string> solver_arguments;
+    double timeout = 20.0;
+    long memory_mb = 0;
+    unsigned jobs = 1;
+    std::string output;
+};
+
+inline bool Solved(Status status) {
+    return status == Status::SAT || status == Status::UNSAT;
+}
+
+// Runs the solver on one instance, collecting stdout and stderr until it
+// exits or the wall clock limit is hit.
+Result Run(const RunOptions& options, const std::filesystem::path& instance) {
+    Result result;
+    result.name = instance.filename().string();
+
+    // Other jobs fork concurrently, and a child inheriting the write ends
+    // would hold back the end of file of this run until it exits. dup2()
+    // clears close-on-exec on the copies the solver writes to.
+    int out_pipe[2];
+    int err_pipe[2];
+    if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+        return result;
+    }
+    if (pipe2(err_pipe, O_CLOEXEC) != 0) {
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        return result;
+    }
+
+    std::vector<std::string> arguments{options.solver};
+    arguments.insert(arguments.end(), options.solver_arguments.begin(), options.solver_arguments.end());
+    arguments.push_back(instance.string());
+    std::vector<char*> argv;
+    for (auto &argument : arguments) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t child = fork();
+    if (child == 0) {
+        if (options.memory_mb > 0) {
+            rlim_t bytes = static_cast<rlim_t>(options.memory_mb) << 20;
+            rlimit limit{bytes, bytes};
+            setrlimit(RLIMIT_AS, &limit);
+        }
+        dup2(out_pipe[1], STDOUT_FILENO);
+        dup2(err_pipe[1], STDERR_FILENO);
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        close(err_pipe[0]);
+        close(err_pipe[1]);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(out_pipe[1]);
+    close(err_pipe[1]);
+    if (child < 0) {
+        close(out_pipe[0]);
+        close(err_pipe[0]);
+        return result;
+    }
+
+    std::string output;
+    std::string errors;
+    pollfd fds[2] = {{out_pipe[0], POLLIN, 0}, {err_pipe[0], POLLIN, 0}};
+    std::string* buffers[2] = {&output, &errors};
+    auto deadline = start + std::chrono::duration<double>(options.timeout);
+    bool timed_out = false;
+    int open_fds = 2;
+    char chunk[1 << 16];
+    while (open_fds > 0) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            timed_out = true;
+            break;
+        }
+        if (poll(fds, 2, static_cast<int>(remaining.count())) < 0 && errno != EINTR) {
+            break;
+        }
+        for (int i = 0; i < 2; i++) {
+            if (fds[i].fd >= 0 && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                ssize_t count = read(fds[i].fd, chunk, sizeof(chunk));
+                if (count > 0) {
+                    buffers[i]->append(chunk, static_cast<std::size_t>(count));
+                } else if (count == 0 || errno != EINTR) {
+                    close(fds[i].fd);
+                    fds[i].fd = -1;
+                    open_fds--;
+                }
+            }
+        }
+    }
+    if (timed_out) {
+        kill(child, SIGKILL);
+    }
+    for (auto &fd : fds) {
+        if (fd.fd >= 0) {
+            close(fd.fd);
+        }
+    }
+
+    int status = 0;
+    rusage usage{};
+    wait4(child, &status, 0, &usage);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.memory_kb = usage.ru_maxrss;
+
+    if (timed_out) {
+        result.status = Status::TIMEOUT;
+        return result;
+    }
+    // SIGKILL not sent by the runner comes from the out of memory killer.
+    // A failed allocation under RLIMIT_AS ends in std::terminate, which
+    // raises SIGABRT after naming the exception, while other aborts are
+    // failed checks.
+    if (WIFSIGNALED(status)) {
+        int signal = WTERMSIG(status);
+        bool out_of_memory = signal == SIGKILL ||
+            (signal == SIGABRT && options.memory_mb > 0 && errors.find("bad_alloc") != std::string::npos);
+        result.status = out_of_memory ? Status::MEMOUT : Status::ERROR;
+        return result;
+    }
+    // Other solvers report their answer as exit status 10 or 20.
+    int exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    if (exit_status != 0 && exit_status != 10 && exit_status != 20) {
+        return result;
+    }
+
+    // Both the native answer lines and competition style s/v lines are
+    // understood.
+    std::istringstream lines(output);
+    std::string line;
+    std::vector<std::int64_t> model;
+    bool satisfiable = false;
+    bool unsatisfiable = false;
+    bool unknown = false;
+    while (std::getline(lines, line)) {
+        if (line == "S" || line == "s SATISFIABLE") {
+            satisfiable = true;
+        } else if (line == "U" || line == "s UNSATISFIABLE") {
+            unsatisfiable = true;
+        } else if (line == "UNKNOWN" || line == "s UNKNOWN") {
+            unknown = true;
+        } else if (line.starts_with("VARS:") || line.starts_with("v ")) {
+            std::istringstream tokens(line.substr(line.find_first_of(": ") + 1));
+            std::string token;
+            while (tokens >> token) {
+                if (token[0] != 'x') {
+                    model.push_back(std::strtoll(token.c_str(), nullptr, 10));
+                }
+            }
+        }
+    }
+    if (unknown && !satisfiable && !unsatisfiable) {
+        result.status = Status::UNKNOWN;
+        return result;
+    }
+    if (satisfiable == unsatisfiable) {
+        return result;
+    }
+    if (unsatisfiable) {
+        result.status = Status::UNSAT;
+        return result;
+    }
+
+    DimacsResult formula = ReadDimacsFromFile(instance.c_str());
+    if (!formula.error.empty()) {
+        return result;
+    }
+    std::vector<bool> is_true(2 * (std::size_t{formula.variable_count} + 1), false);
+    for (std::int64_t lit : model) {
+        if (lit != 0 && static_cast<std::uint64_t>(std::llabs(lit)) <= formula.variable_count) {
+            is_true[NimmerSAT::DimacsToLit(static_cast<std::int32_t>(lit))] = true;
+        }
+    }
+    result.status = Status::SAT;
+    for (NimmerSAT::ClauseId clause : formula.clauses) {
+        auto literals = formula.clauses[clause].literals();
+        if (std::none_of(literals.begin(), literals.end(), [&](NimmerSAT::LitId lit) { return is_true[lit]; })) {
+            result.status = Status::WRONG;
+            break;
+        }
+    }
+    return result;
+}
+
+double Par2(const std::vector<Result>& results, double timeout) {
+    double score = 0.0;
+    for (const auto &result : results) {
+        score += Solved(result.status) ? result.seconds : 2.0 * timeout;
+    }
+    return score;
+}
+
+std::string Quote(std::string_view text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void WriteReport(std::ostream& out, const RunOptions& options, const std::vector<Result>& results) {
+    std::size_t sat = 0;
+    std::size_t unsat = 0;
+    for (const auto &result : results) {
+        sat += result.status == Status::SAT;
+        unsat += result.status == Status::UNSAT;
+    }
+    out << "{\n  \"solver\": " << Quote(options.solver) << ",\n";
+    out << "  \"timeout\": " << options.timeout << ",\n";
+    out << "  \"solved\": " << sat + unsat << ",\n";
+    out << "  \"sat\": " << sat << ",\n";
+    out << "  \"unsat\": " << unsat << ",\n";
+    out << "  \"par2\": " << Par2(results, options.timeout) << ",\n";
+    out << "  \"instances\": [";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const auto &result = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"name\": " << Quote(result.name)
+            << ", \"status\": " << Quote(STATUS_NAMES[static_cast<int>(result.status)])
+            << ", \"time\": " << result.seconds
+            << ", \"memory_kb\": " << result.memory_kb << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int RunCommand(const RunOptions& options) {
+    std::vector<std::filesystem::path> instances;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(options.directory, error)) {
+        if (entry.is_regular_file()) {
+            instances.push_back(entry.path());
+        }
+    }
+    if (error) {
+        std::cerr << "Could not read " << options.directory << ": " << error.message() << std::endl;
+        return 1;
+    }
+    std::sort(instances.begin(), instances.end());
+
+    std::vector<Result> results(instances.size());
+    std::atomic<std::size_t> next{0};
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < std::max(1u, options.jobs); i++) {
+        workers.emplace_back([&] {
+            for (std::size_t index = next++; index < instances.size(); index = next++) {
+                results[index] = Run(options, instances[index]);
+                std::cerr << results[index].name << '\t'
+                          << STATUS_NAMES[static_cast<int>(results[index].status)] << '\t'
+                          << results[index].seconds << std::endl;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    if (options.output.empty()) {
+        WriteReport(std::cout, options, results);
+    } else {
+        std::ofstream file(options.output);
+        WriteReport(file, options, results);
+    }
+
+    bool wrong = std::any_of(results.begin(), results.end(), [](const Result& result) {
+        return result.status == Status::WRONG;
+    });
+    return wrong ? 2 : 0;
+}
+
+// Just enough JSON to read reports back.
+struct Json {
+    double number = 0.0;
+    std::string text;
+    std::vector<Json> items;
+    std::map<std::string, Json> fields;
+
+    const Json& operator[](const std::string& key) const {
+        static const Json missing;
+        auto it = fields.find(key);
+        return it == fields.end() ? missing : it->second;
+    }
+};
+
+class JsonParser final {
+public:
+
+    explicit JsonParser(std::string_view input) : input(input) {
+    }
+
+    bool parse(Json& value) {
+        skip_space();
+        if (position >= input.size()) {
+            return false;
+        }
+        char c = input[position];
+        if (c == '{') {
+            position++;
+            for (;;) {
+                skip_space();
+                if (consume('}')) {
+                    return true;
+                }
+                Json key;
+                if (!parse(key) || (skip_space(), !consume(':'))) {
+                    return false;
+                }
+                if (!parse(value.fields[key.text])) {
+                    return false;
+                }
+                skip_space();
+                consume(',');
+            }
+        }
+        if (c == '[') {
+            position++;
+            for (;;) {
+                skip_space();
+                if (consume(']')) {
+                    return true;
+                }
+                value.items.emplace_back();
+                if (!parse(value.items.back())) {
+                    return false;
+                }
+                skip_space();
+                consume(',');
+            }
+        }
+        if (c == '"') {
+            position++;
+            while (position < input.size() && input[position] != '"') {
+                if (input[position] == '\\') {
+                    position++;
+                }
+                if (position < input.size()) {
+                    value.text += input[position++];
+                }
+            }
+            return consume('"');
+        }
+        std::size_t end = input.find_first_of(",}] \n\t\r", position);
+        std::string token(input.substr(position, end - position));
+        position = end == std::string_view::npos ? input.size() : end;
+        char* parsed_end = nullptr;
+        value.number = std::strtod(token.c_str(), &parsed_end);
+        return !token.empty() && *parsed_end == '\0';
+    }
+
+private:
+
+    inline void skip_space() {
+        while (position < input.size() && std::isspace(static_cast<unsigned char>(input[position]))) {
+            position++;
+        }
+    }
+
+    inline bool consume(char c) {
+        if (position < input.size() && input[position] == c) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    std::string_view input;
+    std::size_t position = 0;
+};
+
+bool ReadReport(const char* path, Json& report) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    if (!file || !JsonParser(contents.str()).parse(report)) {
+        std::cerr << "Could not read report " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Prints the differences between two reports as JSON. Only the instances
+// both reports contain are compared, also for the PAR-2 scores and solved
+// counts, and reports with different timeouts are refused. Returns 1 if the
+// new run is worse: a PAR-2 increase beyond the tolerance, an instance no
+// longer solved, or a contradicting answer.
+int DiffCommand(const char* old_path, const char* new_path, double tolerance) {
+    Json before;
+    Json after;
+    if (!ReadReport(old_path, before) || !ReadReport(new_path, after)) {
+        return 2;
+    }
+    double timeout = before["timeout"].number;
+    if (after["timeout"].number != timeout) {
+        std::cerr << "The reports were run with different timeouts, their PAR-2 scores do not compare" << std::endl;
+        return 2;
+    }
+
+    std::map<std::string, const Json*> old_instances;
+    for (const auto &instance : before["instances"].items) {
+        old_instances[instance["name"].text] = &instance;
+    }
+
+    bool regression = false;
+    std::ostringstream changes;
+    bool first = true;
+    std::size_t common = 0;
+    double old_par2 = 0.0;
+    double new_par2 = 0.0;
+    std::size_t old_solved_count = 0;
+    std::size_t new_solved_count = 0;
+    for (const auto &instance : after["instances"].items) {
+        auto it = old_instances.find(instance["name"].text);
+        if (it == old_instances.end()) {
+            continue;
+        }
+        const Json &old_instance = *it->second;
+        const std::string &old_status = old_instance["status"].text;
+        const std::string &new_status = instance["status"].text;
+        double old_time = old_instance["time"].number;
+        double new_time = instance["time"].number;
+        bool old_solved = old_status == "SAT" || old_status == "UNSAT";
+        bool new_solved = new_status == "SAT" || new_status == "UNSAT";
+        common++;
+        old_par2 += old_solved ? old_time : 2.0 * timeout;
+        new_par2 += new_solved ? new_time : 2.0 * timeout;
+        old_solved_count += old_solved;
+        new_solved_count += new_solved;
+
+        std::string_view change;
+        if (old_solved && new_solved && old_status != new_status) {
+            change = "contradiction";
+            regression = true;
+        } else if (old_status != new_status) {
+            change = new_solved ? "newly solved" : "no longer solved";
+            regression |= old_solved && !new_solved;
+        } else if (old_solved && std::max(old_time, new_time) > 1.0 &&
+                   (new_time > 1.5 * old_time || old_time > 1.5 * new_time)) {
+            change = new_time > old_time ? "slower" : "faster";
+        } else {
+            continue;
+        }
+
+        changes << (first ? "\n" : ",\n");
+        first = false;
+        changes << "    {\"name\": " << Quote(instance["name"].text)
+                << ", \"change\": " << Quote(change)
+                << ", \"old_status\": " << Quote(old_status)
+                << ", \"new_status\": " << Quote(new_status)
+                << ", \"old_time\": " << old_time
+                << ", \"new_time\": " << new_time << "}";
+    }
+
+    double relative = old_par2 > 0.0 ? (new_par2 - old_par2) / old_par2 * 100.0 : 0.0;
+    regression |= relative > tolerance;
+
+    std::cout << "{\n  \"compared\": " << common
+              << ", \"only_old\": " << before["instances"].items.size() - common
+              << ", \"only_new\": " << after["instances"].items.size() - common << ",\n";
+    std::cout << "  \"par2\": {\"old\": " << old_par2 << ", \"new\": " << new_par2
+              << ", \"change_percent\": " << relative << "},\n";
+    std::cout << "  \"solved\": {\"old\": " << old_solved_count
+              << ", \"new\": " << new_solved_count << "},\n";
+    std::cout << "  \"regression\": " << (regression ? "true" : "false") << ",\n";
+    std::cout << "  \"instances\": [" << changes.str() << "\n  ]\n}" << std::endl;
+    return regression ? 1 : 0;
+}
+
+int Usage() {
+    std::cerr << "Usage: nimmersat_bench run --solver=PATH --dir=DIR [--timeout=SECONDS] [--memory=MB]\n"
+                 "                           [--jobs=N] [--output=FILE] [-- SOLVER_ARGS...]\n"
+                 "       nimmersat_bench diff OLD.json NEW.json [--tolerance=PERCENT]" << std::endl;
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        return Usage();
+    }
+    std::string_view command(argv[1]);
+
+    if (command == "diff") {
+        std::vector<const char*> paths;
+        double tolerance = 5.0;
+        for (int i = 2; i < argc; i++) {
+            std::string_view arg(argv[i]);
+            if (arg.starts_with("--tolerance=")) {
+                tolerance = std::strtod(argv[i] + arg.find('=') + 1, nullptr);
+            } else {
+                paths.push_back(argv[i]);
+            }
+        }
+        if (paths.size() != 2) {
+            return Usage();
+        }
+        return DiffCommand(paths[0], paths[1], tolerance);
+    }
+
+    if (command != "run") {
+        return Usage();
+    }
+    RunOptions options;
+    options.jobs = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; i++) {
+        std::string_view arg(argv[i]);
+        const char* value = argv[i] + arg.find('=') + 1;
+        if (arg == "--") {
+            options.solver_arguments.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (arg.starts_with("--solver=")) {
+            options.solver = value;
+        } else if (arg.starts_with("--dir=")) {
+            options.directory = value;
+        } else if (arg.starts_with("--timeout=")) {
+            options.timeout = std::strtod(value, nullptr);
+        } else if (arg.starts_with("--memory=")) {
+            options.memory_mb = std::strtol(value, nullptr, 10);
+        } else if (arg.starts_with("--jobs=")) {
+            options.jobs = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        } else if (arg.starts_with("--output=")) {
+            options.output = value;
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return Usage();
+        }
+    }
+    if (options.solver.empty() || options.directory.empty()) {
+        return Usage();
+    }
+    return RunCommand(options);
+}
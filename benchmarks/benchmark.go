@@ -9,7 +9,7 @@ import (
 	"time"
 )
 
-const exeName = "minisat" //"../build/Release/NimmerSAT"
+const exeName = "../build/Release/NimmerSAT" //"minisat"
 const argPath = "2007SATindustrial/"
 const timeoutMs = 20000
 
@@ -63,7 +63,7 @@ func main() {
 		}
 	}
 	sort.Float64s(timeArr)
-	f, err := os.Create("measurements/2007SATindustrial_minisat.data")
+	f, err := os.Create("measurements/2007SATindustrial_nimmersat.data")
 	if err != nil {
 		fmt.Println(err)
 		return
@@ -0,0 +1,342 @@
+#include "Batch.h"
+#include "Dimacs/Dimacs.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace NimmerSAT {
+
+namespace {
+
+// Buffered reads from a descriptor, by line or by byte count.
+class StreamReader final {
+public:
+
+    explicit StreamReader(int fd) : fd(fd), buffer(BUFFER_SIZE) {
+    }
+
+    // Reads up to the next newline, which is dropped. Returns false at the
+    // end of the stream if nothing was read.
+    bool read_line(std::string& line) {
+        line.clear();
+        for (;;) {
+            if (begin == end && !fill()) {
+                return !line.empty();
+            }
+            const char* newline = static_cast<const char*>(std::memchr(buffer.data() + begin, '\n', end - begin));
+            std::size_t stop = newline != nullptr ? static_cast<std::size_t>(newline - buffer.data()) : end;
+            line.append(buffer.data() + begin, stop - begin);
+            begin = stop;
+            if (newline != nullptr) {
+                begin++;
+                return true;
+            }
+        }
+    }
+
+    // Reads exactly count bytes. Returns false if the stream ends before.
+    // The text grows with the bytes actually read, a length announced by
+    // the sender is not reserved up front.
+    bool read(std::size_t count, std::string& text) {
+        text.clear();
+        while (text.size() < count) {
+            if (begin == end && !fill()) {
+                return false;
+            }
+            std::size_t take = std::min(end - begin, count - text.size());
+            text.append(buffer.data() + begin, take);
+            begin += take;
+        }
+        return true;
+    }
+
+    // Drops count bytes. Returns false if the stream ends before.
+    bool skip(std::size_t count) {
+        while (count > 0) {
+            if (begin == end && !fill()) {
+                return false;
+            }
+            std::size_t take = std::min(end - begin, count);
+            begin += take;
+            count -= take;
+        }
+        return true;
+    }
+
+private:
+
+    constexpr static std::size_t BUFFER_SIZE = 1 << 16;
+
+    bool fill() {
+        for (;;) {
+            ssize_t count = ::read(fd, buffer.data(), buffer.size());
+            if (count > 0) {
+                begin = 0;
+                end = static_cast<std::size_t>(count);
+                return true;
+            }
+            if (count == 0 || errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    int fd;
+    std::vector<char> buffer;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+};
+
+// Longer formulas are answered UNKNOWN without being read into memory.
+constexpr std::size_t MAX_JOB_LENGTH = std::size_t{1} << 30;
+
+// Splits "<id> <bytes>" into its fields.
+bool ParseJobLine(std::string_view line, std::string& id, std::size_t& length) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    std::size_t space = line.find(' ');
+    if (space == 0 || space == std::string_view::npos) {
+        return false;
+    }
+    std::string_view count = line.substr(space + 1);
+    auto [end, error] = std::from_chars(count.data(), count.data() + count.size(), length);
+    if (error != std::errc() || end != count.data() + count.size()) {
+        return false;
+    }
+    id.assign(line.substr(0, space));
+    return true;
+}
+
+}  // namespace
+
+ResultStream::~ResultStream() {
+    if (owned) {
+        close(fd);
+    }
+}
+
+void ResultStream::write(std::string_view text) {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!failed && !text.empty()) {
+        ssize_t count = ::write(fd, text.data(), text.size());
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            failed = true;
+            break;
+        }
+        text.remove_prefix(static_cast<std::size_t>(count));
+    }
+}
+
+BatchSolver::BatchSolver(SolverOptions options, PreprocessorOptions preprocessor_options, SolveBudget budget,
+                         std::uint32_t worker_count) :
+    options(options),
+    preprocessor_options(preprocessor_options),
+    budget(budget),
+    queue_limit(QUEUED_PER_WORKER * worker_count)
+{
+    // The policy is chosen before any formula is known, so Gaussian
+    // elimination stays compiled in while it is enabled.
+    for (std::uint32_t i = 0; i < worker_count; i++) {
+        workers.emplace_back([this] {
+            WithPolicy(this->options, false, this->options.gaussian_elimination, [this](auto policy) {
+                work(policy);
+            });
+        });
+    }
+}
+
+BatchSolver::~BatchSolver() {
+    finish();
+}
+
+void BatchSolver::submit(BatchJob job) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        dequeued.wait(lock, [this] { return jobs.size() < queue_limit; });
+        jobs.push_back(std::move(job));
+    }
+    queued.notify_one();
+}
+
+void BatchSolver::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closing) {
+            return;
+        }
+        closing = true;
+    }
+    queued.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+template <typename Policy>
+void BatchSolver::work(Policy) {
+    BasicSolver<Policy> solver(0, ClauseCache(), options);
+    ClauseCache arena;
+    for (;;) {
+        BatchJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.wait(lock, [this] { return closing || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        dequeued.notify_one();
+
+        job.output->write(solve(job, solver, arena));
+    }
+}
+
+template <typename Policy>
+std::string BatchSolver::solve(const BatchJob& job, BasicSolver<Policy>& solver, ClauseCache& arena) {
+    std::string result = "c job " + job.id + "\n";
+
+    DimacsResult dimacs = job.path.empty() ?
+        ReadDimacsFromMemory(job.text, std::move(arena)) :
+        ReadDimacsFromFile(job.path.c_str(), std::move(arena));
+    if (!dimacs.error.empty()) {
+        arena = std::move(dimacs.clauses);
+        return result + "c " + dimacs.error + "\ns UNKNOWN\n";
+    }
+
+    Preprocessor preprocessor(dimacs.variable_count, std::move(dimacs.clauses), preprocessor_options);
+    if (!preprocessor.run()) {
+        // The parser clears the arena before it reads the next formula.
+        arena = preprocessor.take_clauses();
+        return result + "s UNSATISFIABLE\n";
+    }
+    arena = solver.reset(dimacs.variable_count, preprocessor.take_clauses());
+    solver.set_budget(budget);
+
+    switch (solver.solve()) {
+        case SolveResult::SATISFIABLE:
+            break;
+
+        case SolveResult::UNSATISFIABLE:
+            return result + "s UNSATISFIABLE\n";
+
+        case SolveResult::UNKNOWN:
+            return result + "s UNKNOWN\n";
+    }
+
+    solver.extend_model(preprocessor.reconstruction());
+    result += "s SATISFIABLE\n";
+    std::string line = "v";
+    char number[16];
+    auto append = [&](std::int64_t lit) {
+        auto end = std::to_chars(number, number + sizeof(number), lit).ptr;
+        if (line.size() + static_cast<std::size_t>(end - number) + 1 > 78) {
+            result += line + "\n";
+            line = "v";
+        }
+        line += ' ';
+        line.append(number, end);
+    };
+    for (VarId var = 1; var <= dimacs.variable_count; var++) {
+        bool positive = solver.model_value(VarToLit(var, true)) != Value::FALSE;
+        append(positive ? std::int64_t{var} : -std::int64_t{var});
+    }
+    append(0);
+    return result + line + "\n";
+}
+
+bool ReadJobStream(int fd, BatchSolver& solver, const std::shared_ptr<ResultStream>& output) {
+    StreamReader reader(fd);
+    std::string line;
+    while (reader.read_line(line)) {
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+        BatchJob job;
+        std::size_t length = 0;
+        if (!ParseJobLine(line, job.id, length)) {
+            output->write("c malformed job line: " + line + "\n");
+            return false;
+        }
+        if (length > MAX_JOB_LENGTH) {
+            output->write("c job " + job.id + "\nc formula too large\ns UNKNOWN\n");
+            if (!reader.skip(length)) {
+                return false;
+            }
+            continue;
+        }
+        if (!reader.read(length, job.text)) {
+            output->write("c job " + job.id + "\nc formula ends early\ns UNKNOWN\n");
+            return false;
+        }
+        job.output = output;
+        solver.submit(std::move(job));
+    }
+    return true;
+}
+
+bool ServeJobStreams(const char* path, BatchSolver& solver) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(path) >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::strcpy(address.sun_path, path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        return false;
+    }
+    unlink(path);
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        close(listener);
+        return false;
+    }
+
+    // A client closing its connection early must not end the server.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Readers are detached, the server waits for them before it returns.
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t readers = 0;
+    for (;;) {
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            readers++;
+        }
+        std::thread([&, connection] {
+            ReadJobStream(connection, solver, std::make_shared<ResultStream>(connection, true));
+            std::lock_guard<std::mutex> lock(mutex);
+            readers--;
+            done.notify_all();
+        }).detach();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return readers == 0; });
+    close(listener);
+    return false;
+}
+
+}  // namespace NimmerSAT
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Formula/FormulaCache.h"
+#include "Preprocess/Preprocessor.h"
+#include "Solver/Assign.h"
+#include "Solver/Options.h"
+#include "Solver/Policy.h"
+
+namespace NimmerSAT {
+
+// Where the results of the jobs read from one stream go. Every result is
+// written at once under a lock, so the results of different workers never
+// interleave. An owned descriptor is closed together with the last
+// reference, after the last result of its stream.
+class ResultStream final {
+public:
+
+    ResultStream(int fd, bool owned) : fd(fd), owned(owned) {
+    }
+
+    ResultStream(const ResultStream&) = delete;
+    ResultStream& operator=(const ResultStream&) = delete;
+
+    ~ResultStream();
+
+    // Writes are dropped once one has failed, e.g. after the reader went
+    // away.
+    void write(std::string_view text);
+
+private:
+
+    std::mutex mutex;
+
+    int fd;
+
+    bool owned;
+
+    bool failed = false;
+
+};
+
+struct BatchJob {
+    // Tags the result of the job.
+    std::string id;
+
+    // The formula is read from this file, or taken from text if it is empty.
+    std::string path;
+
+    std::string text;
+
+    std::shared_ptr<ResultStream> output;
+};
+
+// Solves independent formulas on a fixed pool of worker threads. Every
+// worker keeps one solver and one clause arena for all of its jobs and
+// resets them in between, so the memory of the arena, the trail, the heap
+// and the watch lists is allocated once per worker rather than once per
+// formula. Results are written in SAT competition format as soon as they
+// are known, each one preceded by "c job <id>".
+class BatchSolver final {
+public:
+
+    // Every job is solved within budget.
+    BatchSolver(SolverOptions options, PreprocessorOptions preprocessor_options, SolveBudget budget,
+                std::uint32_t worker_count);
+
+    BatchSolver(const BatchSolver&) = delete;
+    BatchSolver& operator=(const BatchSolver&) = delete;
+
+    // Finishes the queued jobs if finish() was not called.
+    ~BatchSolver();
+
+    // Queues a job, waiting while the queue is full so that a fast reader
+    // cannot buffer an unbounded number of formulas.
+    void submit(BatchJob job);
+
+    // Waits for all queued jobs and stops the workers.
+    void finish();
+
+private:
+
+    constexpr static std::size_t QUEUED_PER_WORKER = 4;
+
+    // Runs the jobs with a solver of the policy matching the options.
+    template <typename Policy>
+    void work(Policy policy);
+
+    // The result lines of job.
+    template <typename Policy>
+    std::string solve(const BatchJob& job, BasicSolver<Policy>& solver, ClauseCache& arena);
+
+    SolverOptions options;
+
+    PreprocessorOptions preprocessor_options;
+
+    SolveBudget budget;
+
+    std::mutex mutex;
+
+    std::condition_variable queued;
+
+    std::condition_variable dequeued;
+
+    std::deque<BatchJob> jobs;
+
+    std::size_t queue_limit;
+
+    bool closing = false;
+
+    std::vector<std::thread> workers;
+
+};
+
+// Submits the jobs read from fd until it ends. A job is a line holding its
+// id and the length of the formula in bytes, followed by the formula in
+// DIMACS format:
+//
+//   <id> <bytes>
+//   p cnf ...
+//
+// Formulas of more than 1 GiB are skipped and answered UNKNOWN. Returns
+// false after a malformed job line, which is reported on output.
+bool ReadJobStream(int fd, BatchSolver& solver, const std::shared_ptr<ResultStream>& output);
+
+// Listens on a UNIX domain socket at path. Every connection is a job stream
+// whose results are written back on the same connection. Only returns if
+// the socket cannot be set up or accepting fails.
+bool ServeJobStreams(const char* path, BatchSolver& solver);
+
+}  // namespace NimmerSAT
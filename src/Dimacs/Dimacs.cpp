@@ -1,43 +1,439 @@
+
+
 #include "Dimacs.h"
 
-#include <fstream>
+#include <algorithm>
 #include <string_view>
+#include <cerrno>
+#include <sstream>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace {
+
+// Length of an input that is only known once it has been read.
+constexpr std::size_t UNKNOWN_LENGTH = std::numeric_limits<std::size_t>::max();
+
+// Reads a file mapped into memory. The whole file is one buffer, so
+// refill() only ever reports the end of the input.
+class MappedInput final {
+public:
+
+    explicit MappedInput(const char* path) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            return;
+        }
+        size = static_cast<std::size_t>(info.st_size);
+        if (size == 0) {
+            valid = true;
+            return;
+        }
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            return;
+        }
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapping);
+        valid = true;
+    }
+
+    MappedInput(const MappedInput&) = delete;
+    MappedInput& operator=(const MappedInput&) = delete;
+
+    ~MappedInput() {
+        if (data != nullptr) {
+            munmap(const_cast<char*>(data), size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    inline bool ok() const {
+        return valid;
+    }
+
+    inline std::size_t length() const {
+        return size;
+    }
+
+    inline std::string_view refill() {
+        if (consumed) {
+            return {};
+        }
+        consumed = true;
+        return {data, size};
+    }
+
+private:
+
+    int fd = -1;
+    const char* data = nullptr;
+    std::size_t size = 0;
+    bool valid = false;
+    bool consumed = false;
+};
+
+// A formula already in memory, handed out as a single chunk.
+class MemoryInput final {
+public:
+
+    explicit MemoryInput(std::string_view text) : text(text), size(text.size()) {
+    }
+
+    inline std::size_t length() const {
+        return size;
+    }
+
+    inline std::string_view refill() {
+        return std::exchange(text, std::string_view());
+    }
+
+private:
+
+    std::string_view text;
+    std::size_t size;
+};
+
+// Streams the output of an external decompressor through a pipe, so that
+// compressed formulas never have to be unpacked to disk.
+class DecompressedInput final {
+public:
+
+    DecompressedInput(const char* decompressor, const char* path) : buffer(BUFFER_SIZE) {
+        int pipe_fds[2];
+        if (pipe(pipe_fds) != 0) {
+            return;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&actions, pipe_fds[0]);
+        posix_spawn_file_actions_addclose(&actions, pipe_fds[1]);
+
+        char* argv[] = {const_cast<char*>(decompressor), const_cast<char*>("-dc"),
+                        const_cast<char*>(path), nullptr};
+        int spawned = posix_spawnp(&child, decompressor, &actions, nullptr, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(pipe_fds[1]);
+
+        if (spawned != 0) {
+            close(pipe_fds[0]);
+            child = -1;
+            return;
+        }
+        fd = pipe_fds[0];
+    }
+
+    DecompressedInput(const DecompressedInput&) = delete;
+    DecompressedInput& operator=(const DecompressedInput&) = delete;
+
+    ~DecompressedInput() {
+        decompressor_failed();
+    }
+
+    inline bool ok() const {
+        return fd >= 0;
+    }
+
+    inline std::size_t length() const {
+        return UNKNOWN_LENGTH;
+    }
+
+    inline std::string_view refill() {
+        for (;;) {
+            ssize_t count = read(fd, buffer.data(), buffer.size());
+            if (count > 0) {
+                return {buffer.data(), static_cast<std::size_t>(count)};
+            }
+            if (count == 0 || errno != EINTR) {
+                return {};
+            }
+        }
+    }
+
+    // Waits for the decompressor and reports whether it failed by itself
+    // rather than being stopped by a parse error closing the pipe.
+    bool decompressor_failed() {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+        if (child > 0) {
+            int status = 0;
+            waitpid(child, &status, 0);
+            child = -1;
+            failed = WIFEXITED(status) && WEXITSTATUS(status) != 0;
+        }
+        return failed;
+    }
+
+private:
+
+    constexpr static std::size_t BUFFER_SIZE = 1 << 20;
+
+    int fd = -1;
+    pid_t child = -1;
+    bool failed = false;
+    std::vector<char> buffer;
+};
+
+// Hand written DIMACS parser over any input providing refill(). Literals of
+// the current clause are collected in a reused buffer and appended to the
+// clause arena, so no allocation happens per clause.
+template <typename Input>
+class DimacsParser final {
+public:
+
+    explicit DimacsParser(Input& input) : input(input) {
+    }
+
+    DimacsResult parse(NimmerSAT::ClauseCache clauses) {
+        clauses.clear();
+        DimacsResult result{0, std::move(clauses), {}};
+        std::uint64_t declared_clauses = 0;
+        bool header_seen = false;
+        std::vector<NimmerSAT::LitId> clause;
+
+        for (;;) {
+            skip_whitespace();
+            int c = peek();
+            if (c == END || c == '%') {
+                break;
+            }
+
+            if (c == 'c') {
+                skip_line();
+                continue;
+            }
+
+            if (c == 'p') {
+                if (header_seen) {
+                    return fail(result, "Duplicate problem line");
+                }
+                next();
+                if (!skip_blanks() || !expect("cnf") || !skip_blanks()) {
+                    return fail(result, "Expected 'p cnf <variables> <clauses>'");
+                }
+                std::uint64_t variables;
+                if (!parse_unsigned(variables) || !skip_blanks() || !parse_unsigned(declared_clauses)) {
+                    return fail(result, "Expected 'p cnf <variables> <clauses>'");
+                }
+                if (variables > NimmerSAT::MAX_VARIABLE) {
+                    return fail(result, "Too many variables");
+                }
+                skip_blanks();
+                if (int after = peek(); after != '\n' && after != '\r' && after != END) {
+                    return fail(result, "Unexpected characters after problem line");
+                }
+                // Every clause takes at least two bytes, its 0 and a
+                // separator, and every literal two more.
+                std::uint64_t length = input.length();
+                if (length != UNKNOWN_LENGTH && declared_clauses > length / 2) {
+                    return fail(result, "Problem line declares more clauses than the input holds");
+                }
+                result.variable_count = static_cast<std::uint32_t>(variables);
+                std::uint64_t reserved = std::min(declared_clauses, length == UNKNOWN_LENGTH ?
+                                                  std::uint64_t{MAX_STREAM_RESERVATION} : length / 2);
+                result.clauses.reserve(reserved, std::min(3 * reserved, length / 2));
+                header_seen = true;
+                continue;
+            }
+
+            if (!header_seen) {
+                return fail(result, "Clause before problem line");
+            }
+
+            clause.clear();
+            for (;;) {
+                skip_whitespace();
+                if (peek() == 'c') {
+                    skip_line();
+                    continue;
+                }
+                bool negative = false;
+                if (peek() == '-') {
+                    negative = true;
+                    next();
+                }
+                std::uint64_t var;
+                if (!parse_unsigned(var)) {
+                    return fail(result, peek() == END ? "Missing 0 after last clause" : "Expected literal");
+                }
+                if (var == 0) {
+                    break;
+                }
+                if (var > result.variable_count) {
+                    std::stringstream str;
+                    str << "Literal " << (negative ? "-" : "") << var
+                        << " exceeds declared variable count " << result.variable_count;
+                    return fail(result, str.str());
+                }
+                clause.push_back(NimmerSAT::VarToLit(static_cast<NimmerSAT::VarId>(var), !negative));
+            }
+
+            if (++parsed_clauses > declared_clauses) {
+                return fail(result, "More clauses than declared in problem line");
+            }
+            if (!result.clauses.fits(clause.size())) {
+                return fail(result, "Formula exceeds the clause arena");
+            }
+            // An empty clause is kept, it makes the formula unsatisfiable.
+            result.clauses.add(clause);
+        }
+
+        if (!header_seen) {
+            return fail(result, "Missing problem line");
+        }
+        if (parsed_clauses != declared_clauses) {
+            std::stringstream str;
+            str << "Problem line declares " << declared_clauses << " clauses but "
+                << parsed_clauses << " were found";
+            return fail(result, str.str());
+        }
+        return result;
+    }
+
+private:
+
+    constexpr static int END = -1;
+
+    // Clauses reserved up front for an input of unknown length, the arena
+    // grows beyond.
+    constexpr static std::uint64_t MAX_STREAM_RESERVATION = 1 << 22;
+
+    inline int peek() {
+        if (position == chunk.size()) {
+            chunk = input.refill();
+            position = 0;
+            if (chunk.empty()) {
+                return END;
+            }
+        }
+        return static_cast<unsigned char>(chunk[position]);
+    }
+
+    inline void next() {
+        if (chunk[position++] == '\n') {
+            line++;
+        }
+    }
+
+    inline void skip_whitespace() {
+        for (int c = peek(); c == ' ' || c == '\t' || c == '\n' || c == '\r'; c = peek()) {
+            next();
+        }
+    }
+
+    // Skips spaces and tabs, returns whether any were found.
+    inline bool skip_blanks() {
+        bool skipped = false;
+        for (int c = peek(); c == ' ' || c == '\t'; c = peek()) {
+            next();
+            skipped = true;
+        }
+        return skipped;
+    }
+
+    inline void skip_line() {
+        for (int c = peek(); c != END && c != '\n'; c = peek()) {
+            next();
+        }
+    }
+
+    inline bool expect(std::string_view word) {
+        for (char expected : word) {
+            if (peek() != expected) {
+                return false;
+            }
+            next();
+        }
+        return true;
+    }
+
+    inline bool parse_unsigned(std::uint64_t& value) {
+        int c = peek();
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = 0;
+        do {
+            value = value * 10 + static_cast<std::uint64_t>(c - '0');
+            if (value > std::numeric_limits<std::uint32_t>::max()) {
+                return false;
+            }
+            next();
+            c = peek();
+        } while (c >= '0' && c <= '9');
+        return c == END || c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    DimacsResult fail(DimacsResult& result, std::string_view message) {
+        std::stringstream str;
+        str << "Line " << line << ": " << message;
+        result.error = str.str();
+        return std::move(result);
+    }
+
+    Input& input;
+    std::string_view chunk;
+    std::size_t position = 0;
+    std::uint64_t line = 1;
+    std::uint64_t parsed_clauses = 0;
+};
+
+const char* Decompressor(std::string_view path) {
+    if (path.ends_with(".gz")) {
+        return "gzip";
+    }
+    if (path.ends_with(".xz") || path.ends_with(".lzma")) {
+        return "xz";
+    }
+    if (path.ends_with(".bz2")) {
+        return "bzip2";
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+DimacsResult ReadDimacsFromFile(const char* path, NimmerSAT::ClauseCache clauses) {
+    if (const char* decompressor = Decompressor(path); decompressor != nullptr) {
+        DecompressedInput input(decompressor, path);
+        if (!input.ok()) {
+            return DimacsResult{0, std::move(clauses), std::string("Could not run ") + decompressor};
+        }
+        DimacsResult result = DimacsParser<DecompressedInput>(input).parse(std::move(clauses));
+        if (input.decompressor_failed()) {
+            result.error = std::string(decompressor) + " failed on " + path;
+        }
+        return result;
+    }
+
+    MappedInput input(path);
+    if (!input.ok()) {
+        return DimacsResult{0, std::move(clauses), std::string("Could not open ") + path};
+    }
+    return DimacsParser<MappedInput>(input).parse(std::move(clauses));
+}
 
-#include <iostream>
-
-DimacsResult ReadDimacsFromFile(const char* path) {
-    std::ifstream file(path);
-    DimacsResult result{0, std::vector<NimmerSAT::Clause>()};
-    if (file) {
-        while(!file.eof()) {
-            if (file.peek() == 'c') {
-                file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            } else if (file.peek() == 'p') {
-                std::uint32_t nclauses;
-                file.ignore(6);
-                file >> result.variable_count >> nclauses;
-                result.clauses.reserve(nclauses);
-                file.get();
-            } else {
-                std::vector<NimmerSAT::LitId> clause;
-                int l;
-                do {
-                    if (int x = file.peek();
-                        x == '-' || (x >= '0' && x <= '9')) {
-                        file >> l;
-                        if (l == 0) {
-                            file.get();
-                            break;
-                        }
-                        clause.push_back(l);
-                    }
-                    file.get();
-                } while(!file.eof());
-                if (!clause.empty()) {
-                    result.clauses.push_back(NimmerSAT::Clause(std::move(clause)));
-                }
-            }
-        }
-    }
-    return result;
-}
\ No newline at end of file
+DimacsResult ReadDimacsFromMemory(std::string_view text, NimmerSAT::ClauseCache clauses) {
+    MemoryInput input(text);
+    return DimacsParser<MemoryInput>(input).parse(std::move(clauses));
+}
@@ -1,11 +1,19 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include "Formula/FormulaCache.h"
 
 struct DimacsResult {
     std::uint32_t variable_count;
-    std::vector<NimmerSAT::Clause> clauses;
+    NimmerSAT::ClauseCache clauses;
+
+    // Empty unless reading or parsing failed.
+    std::string error;
 };
 
-DimacsResult ReadDimacsFromFile(const char* path);
+// Both readers fill the given arena, which lets a caller parsing many
+// formulas reuse its memory.
+DimacsResult ReadDimacsFromFile(const char* path, NimmerSAT::ClauseCache clauses = {});
+
+DimacsResult ReadDimacsFromMemory(std::string_view text, NimmerSAT::ClauseCache clauses = {});
@@ -1,15 +1,55 @@
 
+
 #include "FormulaCache.h"
 #include "VariableCache.h"
 
 
 namespace NimmerSAT {
 
-    VariableCache::VariableCache(std::uint32_t size) : variables(size) {
+    VariableCache::VariableCache(std::uint32_t size) :
+        variables(size),
+        values(2 * (std::size_t{size} + 1), Value::UNASSIGNED),
+        levels(size + 1, 0),
+        reasons(size + 1, NO_CLAUSE),
+        watch_lists(2 * (std::size_t{size} + 1)),
+        binary_lists(2 * (std::size_t{size} + 1))
+    {
+    }
+
+    void VariableCache::resize(std::uint32_t size) {
+        if (size <= variables) {
+            return;
+        }
+        variables = size;
+        values.resize(2 * (std::size_t{size} + 1), Value::UNASSIGNED);
+        levels.resize(size + 1, 0);
+        reasons.resize(size + 1, NO_CLAUSE);
+        watch_lists.resize(2 * (std::size_t{size} + 1));
+        binary_lists.resize(2 * (std::size_t{size} + 1));
+    }
+
+    void VariableCache::reset(std::uint32_t size) {
+        clear_clauses();
+        variables = size;
+        values.assign(2 * (std::size_t{size} + 1), Value::UNASSIGNED);
+        levels.assign(size + 1, 0);
+        reasons.assign(size + 1, NO_CLAUSE);
+        watch_lists.resize(2 * (std::size_t{size} + 1));
+        binary_lists.resize(2 * (std::size_t{size} + 1));
     }
 
-    Clause::Clause(std::vector<LitId> literals) : literals(std::move(literals)) {
-        active_literal_count = this->literals.size();
+    ClauseId ClauseCache::add(std::span<const LitId> literals, bool learnt, std::uint32_t lbd) {
+        if (!fits(literals.size())) {
+            Error("Clause arena exceeds 2^31 words");
+        }
+        ClauseId clause = static_cast<ClauseId>(memory.size());
+        memory.push_back(static_cast<LitId>(literals.size()));
+        memory.push_back(learnt ? static_cast<LitId>(Clause::LEARNT) : 0);
+        memory.push_back(0);
+        memory.insert(memory.end(), literals.begin(), literals.end());
+        (*this)[clause].set_lbd(lbd);
+        clause_count++;
+        return clause;
     }
 
 }
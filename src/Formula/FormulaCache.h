@@ -2,65 +2,269 @@
 
 #include <cstdint>
 #include <vector>
-#include <limits>
+#include <span>
+#include <bit>
 #include <cassert>
 
 #include "NSatUtility.h"
 
 namespace NimmerSAT {
 
-struct Clause {
+// View of a clause stored in a ClauseCache. The header words are followed
+// directly by the literals. The first two literals of a clause with at least
+// two literals are its watched literals.
+//
+// A view is invalidated when clauses are added to or collected from its
+// cache.
+class Clause final {
+public:
 
-    constexpr static std::uint32_t UNSATISFIED = std::numeric_limits<std::uint32_t>::max();
+    constexpr static std::uint32_t HEADER_WORDS = 3;
 
-    std::uint32_t satisfied_index = Clause::UNSATISFIED;
-    std::uint32_t active_literal_count;
+    explicit Clause(LitId* header) : header(header) {
+    }
 
-    std::vector<LitId> literals;
+    inline std::uint32_t size() const noexcept {
+        return static_cast<std::uint32_t>(header[SIZE]);
+    }
 
-    explicit Clause(std::vector<LitId> literals);
+    inline bool learnt() const noexcept {
+        return flags() & LEARNT;
+    }
 
-    Clause(const Clause&) = delete;
-    Clause(Clause&&) = default;
+    inline bool deleted() const noexcept {
+        return flags() & DELETED;
+    }
 
-    Clause& operator=(const Clause&) = delete;
-    Clause& operator=(Clause&&) = default;
-    ~Clause() = default;
+    inline void mark_deleted() noexcept {
+        header[FLAGS] = static_cast<LitId>(flags() | DELETED);
+    }
 
-    inline bool satisfied() const noexcept {
-        return satisfied_index != UNSATISFIED;
+    // Number of reductions a learnt clause survives without being used
+    // again in conflict analysis.
+    inline std::uint32_t used() const noexcept {
+        return (flags() & USED_MASK) >> USED_SHIFT;
     }
 
-    inline std::uint32_t active_literals() const noexcept {
-        return active_literal_count;
+    inline void set_used(std::uint32_t used) noexcept {
+        header[FLAGS] = static_cast<LitId>((flags() & ~USED_MASK) | (used << USED_SHIFT));
     }
 
-    inline void set_satisfied(std::uint32_t index) noexcept(!Debug()) {
-        if constexpr (Debug()) {
-            if (index >= literals.size()) {
-                throw std::exception();
-            }
-        }
-        satisfied_index = index;
+    // Literal block distance, only maintained for learnt clauses.
+    inline std::uint32_t lbd() const noexcept {
+        return flags() >> FLAG_BITS;
+    }
+
+    inline void set_lbd(std::uint32_t lbd) noexcept {
+        header[FLAGS] = static_cast<LitId>((lbd << FLAG_BITS) | (flags() & FLAG_MASK));
+    }
+
+    inline float activity() const noexcept {
+        return std::bit_cast<float>(header[ACTIVITY]);
+    }
+
+    inline void set_activity(float activity) noexcept {
+        header[ACTIVITY] = std::bit_cast<LitId>(activity);
+    }
+
+    inline LitId* begin() const noexcept {
+        return header + HEADER_WORDS;
+    }
+
+    inline LitId* end() const noexcept {
+        return begin() + size();
+    }
+
+    inline LitId& operator[](std::uint32_t index) const noexcept {
+        return begin()[index];
+    }
+
+    inline std::span<LitId> literals() const noexcept {
+        return {begin(), size()};
     }
 
     inline void sanitize() const {
-        std::uint32_t literal_count = static_cast<std::uint32_t>(this->literals.size());
-        if (this->active_literals() > literal_count) {
-            std::stringstream str;
-            str << "Active literal count greater than literal count";
-            str << "Active: " << active_literals() << " Count: " << literal_count;
-            Error(str);
+        if (size() == 0) {
+            Error("Empty clause");
         }
+    }
 
-        if (this->satisfied_index != Clause::UNSATISFIED &&
-        this->satisfied_index > literal_count) {
-            Error("Satisfied index invalid");
-        }
+private:
+
+    friend class ClauseCache;
+
+    enum Word : std::uint32_t {
+        SIZE = 0,
+        FLAGS = 1,
+        ACTIVITY = 2
+    };
+
+    constexpr static std::uint32_t LEARNT = 1;
+    constexpr static std::uint32_t DELETED = 2;
+    constexpr static std::uint32_t USED_SHIFT = 2;
+    constexpr static std::uint32_t USED_MASK = 3 << USED_SHIFT;
+    constexpr static std::uint32_t FLAG_BITS = 4;
+    constexpr static std::uint32_t FLAG_MASK = (1 << FLAG_BITS) - 1;
+
+    inline std::uint32_t flags() const noexcept {
+        return static_cast<std::uint32_t>(header[FLAGS]);
     }
 
+    LitId* header;
+
 };
 
-using ClauseCache = std::vector<Clause>;
+// Arena holding all clauses contiguously. A clause is addressed by the
+// 32 bit offset of its header, so following a watcher costs one access into
+// a single allocation.
+class ClauseCache final {
+public:
+
+    // Clause references share their 32 bits with the tagged reasons of
+    // binary clauses, see BINARY_REASON, so the arena stays below 2^31
+    // words.
+    constexpr static std::size_t MAX_WORDS = BINARY_REASON;
+
+    ClauseCache() = default;
+
+    ClauseCache(const ClauseCache&) = delete;
+    ClauseCache(ClauseCache&&) = default;
+
+    ClauseCache& operator=(const ClauseCache&) = delete;
+    ClauseCache& operator=(ClauseCache&&) = default;
+
+    ~ClauseCache() = default;
+
+    class iterator final {
+    public:
+
+        iterator(const ClauseCache& cache, ClauseId clause) : cache(&cache), clause(clause) {
+        }
+
+        inline ClauseId operator*() const {
+            return clause;
+        }
+
+        inline iterator& operator++() {
+            clause += Clause::HEADER_WORDS + cache->memory[clause + Clause::SIZE];
+            return *this;
+        }
+
+        inline bool operator!=(const iterator& other) const {
+            return clause != other.clause;
+        }
+
+    private:
+
+        const ClauseCache* cache;
+        ClauseId clause;
+    };
+
+    // Aborts if the clause does not fit, see fits().
+    ClauseId add(std::span<const LitId> literals, bool learnt = false, std::uint32_t lbd = 0);
+
+    // Whether a clause of size literals can be added.
+    inline bool fits(std::size_t size) const noexcept {
+        return memory.size() + Clause::HEADER_WORDS + size <= MAX_WORDS;
+    }
+
+    // Explicit copy, for solvers that each need a modifiable formula.
+    inline ClauseCache clone() const {
+        ClauseCache copy;
+        copy.memory = memory;
+        copy.clause_count = clause_count;
+        copy.wasted_words = wasted_words;
+        return copy;
+    }
+
+    inline void reserve(std::size_t clause_count, std::size_t literal_count) {
+        memory.reserve(clause_count * Clause::HEADER_WORDS + literal_count);
+    }
+
+    inline Clause operator[](ClauseId clause) {
+        return Clause(memory.data() + clause);
+    }
+
+    inline const Clause operator[](ClauseId clause) const {
+        return Clause(const_cast<LitId*>(memory.data()) + clause);
+    }
+
+    // Drops all clauses but keeps the memory for the next formula.
+    inline void clear() {
+        memory.clear();
+        clause_count = 0;
+        wasted_words = 0;
+    }
+
+    // Deleted clauses keep their memory until the next collect().
+    inline void remove(ClauseId clause) {
+        Clause view = (*this)[clause];
+        view.mark_deleted();
+        wasted_words += Clause::HEADER_WORDS + view.size();
+        clause_count--;
+    }
+
+    // Iterates over all clauses including deleted ones.
+    inline iterator begin() const {
+        return iterator(*this, 0);
+    }
+
+    inline iterator end() const {
+        return iterator(*this, static_cast<ClauseId>(memory.size()));
+    }
+
+    // Number of clauses not deleted.
+    inline std::size_t size() const noexcept {
+        return clause_count;
+    }
+
+    inline bool empty() const noexcept {
+        return clause_count == 0;
+    }
+
+    inline std::size_t memory_words() const noexcept {
+        return memory.size();
+    }
+
+    inline std::size_t wasted() const noexcept {
+        return wasted_words;
+    }
+
+    // Moves all clauses not deleted into a fresh arena. Before the old arena
+    // is released, relocate is called with a function mapping each old
+    // reference to its new one, or to NO_CLAUSE for deleted clauses, so that
+    // the owner can rewrite the references it holds.
+    template <typename Relocate>
+    void collect(Relocate&& relocate) {
+        std::vector<LitId> compacted;
+        compacted.reserve(memory.size() - wasted_words);
+        for (ClauseId clause : *this) {
+            Clause view = (*this)[clause];
+            ClauseId forward = NO_CLAUSE;
+            if (!view.deleted()) {
+                forward = static_cast<ClauseId>(compacted.size());
+                compacted.insert(compacted.end(), memory.data() + clause, view.end());
+            }
+            // The activity word of the old copy is not needed any more.
+            memory[clause + Clause::ACTIVITY] = static_cast<LitId>(forward);
+        }
+
+        relocate([this](ClauseId clause) {
+            return static_cast<ClauseId>(memory[clause + Clause::ACTIVITY]);
+        });
+
+        memory = std::move(compacted);
+        wasted_words = 0;
+    }
+
+private:
+
+    std::vector<LitId> memory;
+
+    std::size_t clause_count = 0;
+
+    std::size_t wasted_words = 0;
+
+};
 
 }  // namespace NimmerSAT
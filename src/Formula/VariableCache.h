@@ -13,11 +13,25 @@
 
 namespace NimmerSAT {
 
+// A clause watching a literal. The blocker is some other literal of the
+// clause; if it is true the clause can be skipped without touching it.
+struct Watcher {
+    ClauseId clause;
+    LitId blocker;
+};
+
 class VariableCache final {
 public:
 
     explicit VariableCache(std::uint32_t size);
 
+    // Adds unassigned variables up to size.
+    void resize(std::uint32_t size);
+
+    // Starts over with size unassigned variables and no clauses. The watch
+    // and binary lists keep their memory.
+    void reset(std::uint32_t size);
+
     VariableCache(const VariableCache&) = delete;
     VariableCache(VariableCache&&) = default;
 
@@ -27,82 +41,72 @@ public:
     ~VariableCache() = default;
 
     inline Value lit_val(LitId index) const {
-        if (index < 0) {
-            return Neg(variables[-index - 1].val);
-        }
-        return variables[index - 1].val;
+        return values[index];
     }
 
     inline Value var_val(VarId index) const {
-        return variables[index - 1].val;
+        return values[VarToLit(index, true)];
     }
 
-    inline const std::vector<ClauseLiteralIndex>& lit_pos_occ(LitId index) const {
-        if (index < 0) {
-            return variables[-index - 1].neg_occ;
-        }
-        return variables[index - 1].pos_occ;
+    inline std::uint32_t var_level(VarId index) const {
+        return levels[index];
     }
 
-    inline std::vector<ClauseLiteralIndex>& lit_pos_occ(LitId index) {
-        if (index < 0) {
-            return variables[-index - 1].neg_occ;
-        }
-        return variables[index - 1].pos_occ;
+    inline ClauseId var_reason(VarId index) const {
+        return reasons[index];
     }
 
-    inline const std::vector<ClauseLiteralIndex>& lit_neg_occ(LitId index) const {
-        if (index < 0) {
-            return variables[-index - 1].pos_occ;
-        }
-        return variables[index - 1].neg_occ;
+    inline const std::vector<Watcher>& watches(LitId index) const {
+        return watch_lists[index];
     }
 
-    inline std::vector<ClauseLiteralIndex>& lit_neg_occ(LitId index) {
-        if (index < 0) {
-            return variables[-index - 1].pos_occ;
-        }
-        return variables[index - 1].neg_occ;
+    inline std::vector<Watcher>& watches(LitId index) {
+        return watch_lists[index];
     }
 
-    inline void observe(LitId literal_index, ClauseLiteralIndex index) {
-        lit_pos_occ(literal_index).push_back(index);
+    inline void watch(LitId literal_index, Watcher watcher) {
+        watches(literal_index).push_back(watcher);
     }
 
-    inline const std::vector<ClauseLiteralIndex>& var_pos_occ(VarId index) const {
-        return variables[index - 1].pos_occ;
+    // Literals implied by the binary clauses containing the negation of
+    // index, i.e. the literals that become true once index is true.
+    inline const std::vector<LitId>& binaries(LitId index) const {
+        return binary_lists[index];
     }
 
-    inline std::vector<ClauseLiteralIndex>& var_pos_occ(VarId index) {
-        return variables[index - 1].pos_occ;
-    }
-
-    inline const std::vector<ClauseLiteralIndex>& var_neg_occ(VarId index) const {
-        return variables[index - 1].neg_occ;
+    // Drops all watchers and binary implications.
+    inline void clear_clauses() {
+        for (auto &watchers : watch_lists) {
+            watchers.clear();
+        }
+        for (auto &implied : binary_lists) {
+            implied.clear();
+        }
     }
 
-    inline std::vector<ClauseLiteralIndex>& var_neg_occ(VarId index) {
-        return variables[index - 1].neg_occ;
+    inline void add_binary(LitId first, LitId second) {
+        binary_lists[Neg(first)].push_back(second);
+        binary_lists[Neg(second)].push_back(first);
     }
 
-    inline void set_var(VarId var, Value val) {
-        variables[var - 1].val = val;
+    inline void set_reason(VarId var, ClauseId reason) {
+        reasons[var] = reason;
     }
 
-    inline void set_lit(LitId lit) {
-        if (lit < 0) {
-            variables[-lit - 1].val = Value::FALSE;
-        } else {
-            variables[lit - 1].val = Value::TRUE;
-        }
+    inline void set_lit(LitId lit, std::uint32_t level, ClauseId reason) {
+        values[lit] = Value::TRUE;
+        values[Neg(lit)] = Value::FALSE;
+        levels[LitToVar(lit)] = level;
+        reasons[LitToVar(lit)] = reason;
     }
 
     inline void unset_lit(LitId lit) {
-        set_var(LitToVar(lit), Value::UNASSIGNED);
+        values[lit] = Value::UNASSIGNED;
+        values[Neg(lit)] = Value::UNASSIGNED;
     }
 
     inline std::uint32_t variable_count() const {
-        return variables.size();
+        return variables;
     }
 
     void print() const {
@@ -127,14 +131,20 @@ public:
 
 private:
 
-    struct Variable {
-        Value val = Value::UNASSIGNED;
+    // Arrays are indexed by variable or literal directly, index 0 is unused.
+    // Values are kept per literal so that looking up a negative literal does
+    // not need a branch.
+    std::uint32_t variables;
+
+    std::vector<Value> values;
+
+    std::vector<std::uint32_t> levels;
+
+    std::vector<ClauseId> reasons;
 
-        std::vector<ClauseLiteralIndex> pos_occ;
-        std::vector<ClauseLiteralIndex> neg_occ;
-    };
+    std::vector<std::vector<Watcher>> watch_lists;
 
-    std::vector<Variable> variables;
+    std::vector<std::vector<LitId>> binary_lists;
 
 };
 
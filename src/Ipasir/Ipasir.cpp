@@ -0,0 +1,139 @@
+
+#include "ipasir.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include "Solver/Assign.h"
+
+namespace {
+
+// A solver together with the clause and assumptions being built. Variables
+// are added as literals referring to them arrive.
+struct IpasirSolver {
+    NimmerSAT::Solver solver{0, NimmerSAT::ClauseCache()};
+
+    std::vector<NimmerSAT::LitId> clause;
+
+    std::vector<NimmerSAT::LitId> assumptions;
+
+    std::vector<int> learnt;
+
+    NimmerSAT::LitId literal(int lit) {
+        // Also rejects INT_MIN, which has no absolute value.
+        constexpr int max_variable = static_cast<int>(NimmerSAT::MAX_VARIABLE);
+        if (lit < -max_variable || lit > max_variable) {
+            NimmerSAT::Error("Variable exceeds the largest supported variable");
+        }
+        solver.reserve_variables(static_cast<std::uint32_t>(std::abs(lit)));
+        return NimmerSAT::DimacsToLit(lit);
+    }
+};
+
+IpasirSolver& Get(void* solver) {
+    return *static_cast<IpasirSolver*>(solver);
+}
+
+}  // namespace
+
+extern "C" {
+
+const char* ipasir_signature(void) {
+    return "NimmerSAT";
+}
+
+void* ipasir_init(void) {
+    return new IpasirSolver();
+}
+
+void ipasir_release(void* solver) {
+    delete static_cast<IpasirSolver*>(solver);
+}
+
+void ipasir_add(void* solver, int lit) {
+    IpasirSolver &state = Get(solver);
+    if (lit != 0) {
+        state.clause.push_back(state.literal(lit));
+        return;
+    }
+    state.solver.add_clause(state.clause);
+    state.clause.clear();
+}
+
+void ipasir_assume(void* solver, int lit) {
+    IpasirSolver &state = Get(solver);
+    state.assumptions.push_back(state.literal(lit));
+}
+
+int ipasir_solve(void* solver) {
+    IpasirSolver &state = Get(solver);
+    NimmerSAT::SolveResult result = state.solver.solve(state.assumptions);
+    state.assumptions.clear();
+    switch (result) {
+        case NimmerSAT::SolveResult::SATISFIABLE:
+            return 10;
+
+        case NimmerSAT::SolveResult::UNSATISFIABLE:
+            return 20;
+
+        case NimmerSAT::SolveResult::UNKNOWN:
+            return 0;
+    }
+    return 0;
+}
+
+int ipasir_val(void* solver, int lit) {
+    IpasirSolver &state = Get(solver);
+    if (static_cast<std::uint32_t>(std::abs(lit)) > state.solver.variable_count()) {
+        return 0;
+    }
+    switch (state.solver.model_value(NimmerSAT::DimacsToLit(lit))) {
+        case NimmerSAT::Value::TRUE:
+            return lit;
+
+        case NimmerSAT::Value::FALSE:
+            return -lit;
+
+        case NimmerSAT::Value::UNASSIGNED:
+            return 0;
+    }
+    return 0;
+}
+
+int ipasir_failed(void* solver, int lit) {
+    IpasirSolver &state = Get(solver);
+    if (static_cast<std::uint32_t>(std::abs(lit)) > state.solver.variable_count()) {
+        return 0;
+    }
+    return state.solver.failed(NimmerSAT::DimacsToLit(lit)) ? 1 : 0;
+}
+
+void ipasir_set_terminate(void* solver, void* data, int (*terminate)(void* data)) {
+    IpasirSolver &state = Get(solver);
+    if (terminate == nullptr) {
+        state.solver.set_terminate_callback(nullptr);
+        return;
+    }
+    state.solver.set_terminate_callback([data, terminate] {
+        return terminate(data) != 0;
+    });
+}
+
+void ipasir_set_learn(void* solver, void* data, int max_length, void (*learn)(void* data, int* clause)) {
+    IpasirSolver &state = Get(solver);
+    if (learn == nullptr || max_length < 0) {
+        state.solver.set_learn_callback(0, nullptr);
+        return;
+    }
+    state.solver.set_learn_callback(static_cast<std::uint32_t>(max_length),
+                                    [&state, data, learn](std::span<const NimmerSAT::LitId> clause) {
+        state.learnt.clear();
+        for (NimmerSAT::LitId lit : clause) {
+            state.learnt.push_back(NimmerSAT::LitToDimacs(lit));
+        }
+        state.learnt.push_back(0);
+        learn(data, state.learnt.data());
+    });
+}
+
+}  // extern "C"
@@ -0,0 +1,43 @@
+#pragma once
+
+// Standard incremental SAT solver interface (IPASIR) as used by the SAT
+// competition incremental track. Literals are non-zero DIMACS integers.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Name and version of the solver.
+const char* ipasir_signature(void);
+
+// New solver in state INPUT.
+void* ipasir_init(void);
+
+void ipasir_release(void* solver);
+
+// Adds lit to the clause being built, or finishes the clause on 0.
+void ipasir_add(void* solver, int lit);
+
+// Assumes lit for the next call of ipasir_solve only.
+void ipasir_assume(void* solver, int lit);
+
+// Returns 10 if satisfiable, 20 if unsatisfiable and 0 if interrupted.
+int ipasir_solve(void* solver);
+
+// After 10: lit if lit is true, -lit if it is false, 0 if it does not
+// matter.
+int ipasir_val(void* solver, int lit);
+
+// After 20: 1 if the assumption lit was used to prove unsatisfiability.
+int ipasir_failed(void* solver, int lit);
+
+// ipasir_solve returns 0 soon after terminate(data) returns non-zero.
+void ipasir_set_terminate(void* solver, void* data, int (*terminate)(void* data));
+
+// learn(data, clause) is called with every learnt clause of up to max_length
+// literals, clause being terminated by 0.
+void ipasir_set_learn(void* solver, void* data, int max_length, void (*learn)(void* data, int* clause));
+
+#ifdef __cplusplus
+}
+#endif
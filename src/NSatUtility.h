@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <utility>
 #include <cmath>
+#include <limits>
 
 #include <iostream>
 #include <sstream>
@@ -10,27 +11,72 @@
 namespace NimmerSAT {
 
     using VarId = std::uint32_t;
-    using LitId = std::int32_t;
+    // Literals are encoded as 2 * var + sign, so a literal and its negation
+    // differ only in the lowest bit and literals can index arrays directly.
+    using LitId = std::uint32_t;
     using ClauseId = std::uint32_t;
-    using ClauseLiteralIndex = std::pair<ClauseId, std::uint32_t>;
+
+    // Reason of decisions and of literals assigned without a clause.
+    constexpr ClauseId NO_CLAUSE = std::numeric_limits<ClauseId>::max();
+
+    // Literals implied by binary clauses do not have a clause in the arena.
+    // Their reason is the other literal of the binary clause, tagged with
+    // the highest bit.
+    constexpr ClauseId BINARY_REASON = ClauseId{1} << 31;
+
+    inline ClauseId BinaryReason(LitId other) {
+        return BINARY_REASON | other;
+    }
+
+    // Literals implied by Gaussian elimination over XOR constraints, and the
+    // conflicts it finds, have their clause kept by the GaussEngine.
+    constexpr ClauseId XOR_REASON = NO_CLAUSE - 1;
+    constexpr ClauseId XOR_CONFLICT = NO_CLAUSE - 2;
+
+    // Highest variable whose literals, tagged as binary reasons, stay below
+    // XOR_CONFLICT.
+    constexpr VarId MAX_VARIABLE = (XOR_CONFLICT - BINARY_REASON - 2) / 2;
+    static_assert((BINARY_REASON | (2 * MAX_VARIABLE + 1)) < XOR_CONFLICT);
+    static_assert((BINARY_REASON | (2 * (MAX_VARIABLE + 1) + 1)) >= XOR_CONFLICT);
+
+    inline bool IsBinaryReason(ClauseId reason) {
+        return reason < XOR_CONFLICT && (reason & BINARY_REASON) != 0;
+    }
+
+    inline bool IsXorReason(ClauseId reason) {
+        return reason == XOR_REASON || reason == XOR_CONFLICT;
+    }
+
+    inline LitId BinaryReasonLit(ClauseId reason) {
+        return reason & ~BINARY_REASON;
+    }
 
     inline VarId LitToVar(LitId lit_id) {
-        return std::abs(lit_id);
+        return lit_id >> 1;
     }
 
     inline LitId VarToLit(VarId var_id, bool pos) {
-        LitId lit = static_cast<LitId>(var_id);
-        if (!pos) {
-            lit = -lit;
-        }
-        return lit;
+        return (var_id << 1) | static_cast<LitId>(!pos);
     }
 
     inline LitId Neg(LitId lit_id) {
-        return -lit_id;
+        return lit_id ^ 1;
     }
 
-    enum class Value{
+    inline bool IsPositive(LitId lit_id) {
+        return (lit_id & 1) == 0;
+    }
+
+    inline LitId DimacsToLit(std::int32_t dimacs) {
+        return dimacs < 0 ? VarToLit(static_cast<VarId>(-dimacs), false) : VarToLit(static_cast<VarId>(dimacs), true);
+    }
+
+    inline std::int32_t LitToDimacs(LitId lit_id) {
+        std::int32_t var = static_cast<std::int32_t>(LitToVar(lit_id));
+        return IsPositive(lit_id) ? var : -var;
+    }
+
+    enum class Value : std::uint8_t {
         UNASSIGNED,
         TRUE,
         FALSE
@@ -47,6 +93,7 @@ namespace NimmerSAT {
             case Value::FALSE:
                 return Value::TRUE;
         }
+        return Value::UNASSIGNED;
     }
 
     inline void Error(std::string str = {}) {
@@ -72,4 +119,13 @@ namespace NimmerSAT {
         #endif
     }
 
+    // Search statistics are counted unless disabled at compile time.
+    constexpr bool Stats() {
+        #ifdef NIMMERSAT_NO_STATS
+            return false;
+        #else
+            return true;
+        #endif
+    }
+
 }  // namespace NimmerSAT
@@ -0,0 +1,354 @@
+
+#include "Preprocessor.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace NimmerSAT {
+
+Preprocessor::Preprocessor(std::uint32_t variable_count, ClauseCache clauses, PreprocessorOptions options) :
+    options(options),
+    variable_count(variable_count),
+    clauses(std::move(clauses)),
+    occurrence_lists(2 * (std::size_t{variable_count} + 1)),
+    values(2 * (std::size_t{variable_count} + 1), Value::UNASSIGNED),
+    eliminated(variable_count + 1, false),
+    literal_stamp(2 * (std::size_t{variable_count} + 1), 0)
+{
+}
+
+bool Preprocessor::run() {
+    if (!options.enabled) {
+        return true;
+    }
+
+    ClauseCache input = std::move(clauses);
+    clauses = ClauseCache();
+    if (!load(input) || !propagate_units() || !subsume_queued()) {
+        return refute();
+    }
+
+    // Cheap variables first. Eliminations change the occurrence counts, so
+    // the order is recomputed for every round.
+    bool progress = true;
+    while (progress && !out_of_budget()) {
+        progress = false;
+
+        std::vector<std::pair<std::uint64_t, VarId>> order;
+        for (VarId var = 1; var <= variable_count; var++) {
+            if (!eliminated[var] && values[VarToLit(var, true)] == Value::UNASSIGNED) {
+                std::uint64_t cost = std::uint64_t{occurrences(VarToLit(var, true)).size()} *
+                    occurrences(VarToLit(var, false)).size();
+                order.emplace_back(cost, var);
+            }
+        }
+        std::sort(order.begin(), order.end());
+
+        for (auto [cost, var] : order) {
+            if (out_of_budget()) {
+                break;
+            }
+            std::uint32_t before = eliminated_variables;
+            if (!try_eliminate(var) || !propagate_units() || !subsume_queued()) {
+                return refute();
+            }
+            progress |= eliminated_variables != before;
+        }
+    }
+    return true;
+}
+
+bool Preprocessor::refute() {
+    if (proof != nullptr) {
+        proof->add({});
+    }
+    return false;
+}
+
+ClauseCache Preprocessor::take_clauses() {
+    if (!options.enabled) {
+        return std::move(clauses);
+    }
+
+    clauses.collect([](auto) {});
+    for (LitId unit : units) {
+        clauses.add(std::span<const LitId>(&unit, 1));
+    }
+    return std::move(clauses);
+}
+
+bool Preprocessor::load(ClauseCache& input) {
+    std::vector<LitId> literals;
+    for (ClauseId clause : input) {
+        current_stamp++;
+        literals.clear();
+        bool satisfied = false;
+        for (LitId lit : input[clause]) {
+            if (literal_stamp[Neg(lit)] == current_stamp || values[lit] == Value::TRUE) {
+                satisfied = true;
+                break;
+            }
+            if (literal_stamp[lit] != current_stamp && values[lit] == Value::UNASSIGNED) {
+                literal_stamp[lit] = current_stamp;
+                literals.push_back(lit);
+            }
+        }
+        if (satisfied) {
+            continue;
+        }
+        // Clauses without their false literals are implied by the units.
+        if (proof != nullptr && literals.size() != input[clause].size()) {
+            proof->add(literals);
+        }
+        if (!add_clause(literals)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Preprocessor::add_clause(std::span<const LitId> literals) {
+    if (literals.empty()) {
+        return false;
+    }
+    if (literals.size() == 1) {
+        return assign_unit(literals[0]);
+    }
+
+    std::uint32_t index = static_cast<std::uint32_t>(references.size());
+    references.push_back(clauses.add(literals));
+    signatures.push_back(Signature(literals));
+    subsumption_queue.push_back(index);
+    for (LitId lit : literals) {
+        occurrence_lists[lit].push_back(index);
+    }
+    return true;
+}
+
+void Preprocessor::remove_clause(std::uint32_t index) {
+    if (!removed(index)) {
+        if (proof != nullptr) {
+            proof->remove(clauses[references[index]].literals());
+        }
+        clauses.remove(references[index]);
+    }
+}
+
+bool Preprocessor::assign_unit(LitId lit) {
+    if (values[lit] != Value::UNASSIGNED) {
+        return values[lit] == Value::TRUE;
+    }
+    values[lit] = Value::TRUE;
+    values[Neg(lit)] = Value::FALSE;
+    units.push_back(lit);
+    return true;
+}
+
+bool Preprocessor::propagate_units() {
+    while (propagated_units < units.size()) {
+        LitId unit = units[propagated_units++];
+        for (std::uint32_t index : occurrences(unit)) {
+            remove_clause(index);
+        }
+        std::vector<std::uint32_t> falsified = occurrences(Neg(unit));
+        for (std::uint32_t index : falsified) {
+            if (!removed(index) && !strengthen(index, Neg(unit))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<std::uint32_t>& Preprocessor::occurrences(LitId lit) {
+    auto &list = occurrence_lists[lit];
+    steps += list.size();
+    list.erase(std::remove_if(list.begin(), list.end(), [this](std::uint32_t index) {
+        return removed(index);
+    }), list.end());
+    return list;
+}
+
+bool Preprocessor::subsume_queued() {
+    while (!subsumption_queue.empty()) {
+        if (out_of_budget()) {
+            subsumption_queue.clear();
+            break;
+        }
+        std::uint32_t index = subsumption_queue.back();
+        subsumption_queue.pop_back();
+        if (!removed(index) && (!backward_subsume(index) || !propagate_units())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Preprocessor::backward_subsume(std::uint32_t index) {
+    // Strengthening adds clauses, so the literals are copied out of the
+    // arena first.
+    Clause clause = clauses[references[index]];
+    std::vector<LitId> literals(clause.begin(), clause.end());
+    std::uint64_t signature = signatures[index];
+
+    LitId best = literals[0];
+    std::size_t best_count = std::numeric_limits<std::size_t>::max();
+    current_stamp++;
+    for (LitId lit : literals) {
+        literal_stamp[lit] = current_stamp;
+        std::size_t count = occurrences(lit).size() + occurrences(Neg(lit)).size();
+        if (count < best_count) {
+            best = lit;
+            best_count = count;
+        }
+    }
+
+    // Every clause subsumed by, or strengthened with, this clause contains
+    // best or its negation.
+    for (LitId candidate_lit : {best, Neg(best)}) {
+        std::vector<std::uint32_t> candidates = occurrences(candidate_lit);
+        for (std::uint32_t other : candidates) {
+            if (other == index || removed(other) || (signature & ~signatures[other]) != 0) {
+                continue;
+            }
+            Clause candidate = clauses[references[other]];
+            if (candidate.size() < literals.size()) {
+                continue;
+            }
+            steps += candidate.size();
+
+            std::size_t same = 0;
+            std::size_t flipped = 0;
+            LitId flipped_lit = 0;
+            for (LitId lit : candidate) {
+                if (literal_stamp[lit] == current_stamp) {
+                    same++;
+                } else if (literal_stamp[Neg(lit)] == current_stamp) {
+                    flipped++;
+                    flipped_lit = lit;
+                }
+            }
+
+            if (same == literals.size()) {
+                remove_clause(other);
+            } else if (same + 1 == literals.size() && flipped == 1) {
+                if (!strengthen(other, flipped_lit)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool Preprocessor::strengthen(std::uint32_t index, LitId removed_lit) {
+    std::vector<LitId> literals;
+    for (LitId lit : clauses[references[index]]) {
+        if (lit != removed_lit) {
+            literals.push_back(lit);
+        }
+    }
+    // The proof needs the original to derive the strengthened clause.
+    if (proof != nullptr) {
+        proof->add(literals);
+    }
+    remove_clause(index);
+    return add_clause(literals);
+}
+
+bool Preprocessor::try_eliminate(VarId var) {
+    if (eliminated[var] || values[VarToLit(var, true)] != Value::UNASSIGNED) {
+        return true;
+    }
+
+    std::vector<std::uint32_t> positive = occurrences(VarToLit(var, true));
+    std::vector<std::uint32_t> negative = occurrences(VarToLit(var, false));
+    if (positive.empty() && negative.empty()) {
+        return true;
+    }
+    if (positive.size() + negative.size() > options.occurrence_limit) {
+        return true;
+    }
+
+    // Eliminate only if the non-tautological resolvents do not outnumber
+    // the clauses they replace.
+    std::size_t limit = positive.size() + negative.size();
+    std::vector<LitId> resolvents;
+    std::vector<std::uint32_t> resolvent_sizes;
+    for (std::uint32_t p : positive) {
+        for (std::uint32_t n : negative) {
+            if (!resolve(p, n, var)) {
+                continue;
+            }
+            if (resolvent.size() > options.resolvent_length_limit || resolvent_sizes.size() == limit) {
+                return true;
+            }
+            resolvents.insert(resolvents.end(), resolvent.begin(), resolvent.end());
+            resolvent_sizes.push_back(static_cast<std::uint32_t>(resolvent.size()));
+        }
+    }
+
+    // Resolvents enter the proof before the clauses they are derived from
+    // are deleted.
+    if (proof != nullptr) {
+        std::size_t offset = 0;
+        for (std::uint32_t size : resolvent_sizes) {
+            proof->add(std::span<const LitId>(resolvents.data() + offset, size));
+            offset += size;
+        }
+    }
+
+    for (const auto *side : {&positive, &negative}) {
+        LitId witness = VarToLit(var, side == &positive);
+        for (std::uint32_t index : *side) {
+            eliminated_clauses.push(witness, clauses[references[index]].literals());
+            remove_clause(index);
+        }
+    }
+    eliminated[var] = true;
+    eliminated_variables++;
+
+    std::size_t offset = 0;
+    for (std::uint32_t size : resolvent_sizes) {
+        if (!add_clause(std::span<const LitId>(resolvents.data() + offset, size))) {
+            return false;
+        }
+        offset += size;
+    }
+    return true;
+}
+
+bool Preprocessor::resolve(std::uint32_t positive, std::uint32_t negative, VarId var) {
+    current_stamp++;
+    resolvent.clear();
+    Clause first = clauses[references[positive]];
+    Clause second = clauses[references[negative]];
+    steps += first.size() + second.size();
+
+    for (LitId lit : first) {
+        if (LitToVar(lit) != var) {
+            literal_stamp[lit] = current_stamp;
+            resolvent.push_back(lit);
+        }
+    }
+    for (LitId lit : second) {
+        if (LitToVar(lit) == var || literal_stamp[lit] == current_stamp) {
+            continue;
+        }
+        if (literal_stamp[Neg(lit)] == current_stamp) {
+            return false;
+        }
+        resolvent.push_back(lit);
+    }
+    return true;
+}
+
+std::uint64_t Preprocessor::Signature(std::span<const LitId> literals) {
+    std::uint64_t signature = 0;
+    for (LitId lit : literals) {
+        signature |= std::uint64_t{1} << (LitToVar(lit) & 63);
+    }
+    return signature;
+}
+
+}  // namespace NimmerSAT
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Formula/FormulaCache.h"
+#include "Preprocess/Reconstruction.h"
+#include "Proof/Proof.h"
+#include "NSatUtility.h"
+
+namespace NimmerSAT {
+
+struct PreprocessorOptions {
+    bool enabled = true;
+
+    // Upper bound on occurrence list and literal visits, checked between
+    // individual simplifications.
+    std::uint64_t step_budget = 200'000'000;
+
+    // Variables occurring more often than this are not eliminated.
+    std::uint32_t occurrence_limit = 64;
+
+    // Eliminations producing longer resolvents are rejected.
+    std::uint32_t resolvent_length_limit = 24;
+};
+
+// SatELite style simplification run once before search: top level unit
+// propagation, backward subsumption, self-subsuming resolution and bounded
+// variable elimination. Clauses live in a ClauseCache arena of their own and
+// are addressed by a dense index for signatures and occurrence lists.
+class Preprocessor final {
+public:
+
+    Preprocessor(std::uint32_t variable_count, ClauseCache clauses, PreprocessorOptions options = {});
+
+    Preprocessor(const Preprocessor&) = delete;
+    Preprocessor(Preprocessor&&) = default;
+    Preprocessor& operator=(const Preprocessor&) = delete;
+    Preprocessor& operator=(Preprocessor&&) = default;
+    ~Preprocessor() = default;
+
+    // Returns false if the formula was found to be unsatisfiable.
+    bool run();
+
+    // The simplified formula, including the units found.
+    ClauseCache take_clauses();
+
+    inline const ModelReconstruction& reconstruction() const {
+        return eliminated_clauses;
+    }
+
+    inline std::uint32_t eliminated_count() const {
+        return eliminated_variables;
+    }
+
+    // Records added and removed clauses as a DRAT proof.
+    inline void set_proof(ProofWriter* writer) {
+        proof = writer;
+    }
+
+private:
+
+    // Adds the empty clause to the proof and returns false.
+    bool refute();
+
+    // Copies the input into the arena of the preprocessor, dropping duplicate
+    // literals and tautologies. Returns false on an empty clause.
+    bool load(ClauseCache& input);
+
+    // Adds a clause over unassigned literals. Units are queued instead.
+    bool add_clause(std::span<const LitId> literals);
+
+    void remove_clause(std::uint32_t index);
+
+    bool assign_unit(LitId lit);
+
+    bool propagate_units();
+
+    // Removes deleted clauses from the occurrence list of lit.
+    std::vector<std::uint32_t>& occurrences(LitId lit);
+
+    bool subsume_queued();
+
+    bool backward_subsume(std::uint32_t index);
+
+    // Replaces clause index by a copy without the literal removed.
+    bool strengthen(std::uint32_t index, LitId removed);
+
+    bool try_eliminate(VarId var);
+
+    // Resolves the two clauses on var into resolvent. Returns false if the
+    // resolvent is a tautology.
+    bool resolve(std::uint32_t positive, std::uint32_t negative, VarId var);
+
+    inline bool removed(std::uint32_t index) const {
+        return clauses[references[index]].deleted();
+    }
+
+    inline bool out_of_budget() const {
+        return steps > options.step_budget;
+    }
+
+    static std::uint64_t Signature(std::span<const LitId> literals);
+
+    PreprocessorOptions options;
+
+    std::uint32_t variable_count;
+
+    ClauseCache clauses;
+
+    std::vector<ClauseId> references;
+
+    std::vector<std::uint64_t> signatures;
+
+    std::vector<std::vector<std::uint32_t>> occurrence_lists;
+
+    std::vector<Value> values;
+
+    std::vector<LitId> units;
+
+    std::size_t propagated_units = 0;
+
+    std::vector<bool> eliminated;
+
+    std::uint32_t eliminated_variables = 0;
+
+    std::vector<std::uint32_t> subsumption_queue;
+
+    std::vector<std::uint64_t> literal_stamp;
+
+    std::uint64_t current_stamp = 0;
+
+    std::vector<LitId> resolvent;
+
+    std::uint64_t steps = 0;
+
+    ModelReconstruction eliminated_clauses;
+
+    ProofWriter* proof = nullptr;
+
+};
+
+}  // namespace NimmerSAT
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "NSatUtility.h"
+
+namespace NimmerSAT {
+
+// Clauses removed by variable elimination, each with the literal of the
+// eliminated variable it contained. Replaying them in reverse order and
+// making the witness true wherever a clause is falsified turns a model of
+// the simplified formula into a model of the original one.
+class ModelReconstruction final {
+public:
+
+    ModelReconstruction() = default;
+
+    ModelReconstruction(const ModelReconstruction&) = delete;
+    ModelReconstruction(ModelReconstruction&&) = default;
+
+    ModelReconstruction& operator=(const ModelReconstruction&) = delete;
+    ModelReconstruction& operator=(ModelReconstruction&&) = default;
+
+    ~ModelReconstruction() = default;
+
+    // Layout per entry: the clause literals, the witness, the clause size.
+    inline void push(LitId witness, std::span<const LitId> clause) {
+        stack.insert(stack.end(), clause.begin(), clause.end());
+        stack.push_back(witness);
+        stack.push_back(static_cast<LitId>(clause.size()));
+    }
+
+    inline void clear() noexcept {
+        stack.clear();
+    }
+
+    inline bool empty() const noexcept {
+        return stack.empty();
+    }
+
+    // The model holds the value of every literal.
+    void extend(std::vector<Value>& model) const {
+        std::size_t end = stack.size();
+        while (end > 0) {
+            std::uint32_t size = stack[end - 1];
+            LitId witness = stack[end - 2];
+            std::size_t begin = end - 2 - size;
+
+            bool satisfied = false;
+            for (std::size_t i = begin; i < begin + size; i++) {
+                if (model[stack[i]] == Value::TRUE) {
+                    satisfied = true;
+                    break;
+                }
+            }
+            if (!satisfied) {
+                model[witness] = Value::TRUE;
+                model[Neg(witness)] = Value::FALSE;
+            }
+            end = begin;
+        }
+    }
+
+private:
+
+    std::vector<LitId> stack;
+
+};
+
+}  // namespace NimmerSAT
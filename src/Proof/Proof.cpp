@@ -0,0 +1,115 @@
+#include "Proof.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace NimmerSAT {
+
+ProofWriter::ProofWriter(const char* path, ProofFormat format) :
+    format(format),
+    file(std::fopen(path, "wb"))
+{
+    if (file == nullptr) {
+        return;
+    }
+    // The file is written in large chunks already.
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    current.data = std::make_unique<char[]>(BUFFER_SIZE);
+    current.capacity = BUFFER_SIZE;
+    writer = std::thread([this] { run(); });
+}
+
+ProofWriter::~ProofWriter() {
+    close();
+}
+
+bool ProofWriter::close() {
+    if (file == nullptr) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        full.push_back(std::move(current));
+        closing = true;
+    }
+    queued.notify_one();
+    writer.join();
+
+    bool success = !failed && std::fclose(file) == 0;
+    file = nullptr;
+    return success;
+}
+
+char* ProofWriter::encode_binary(char* out, char kind, std::span<const LitId> clause) {
+    // Literals are mapped to 2 * var + sign, which is exactly LitId.
+    *out++ = kind;
+    for (LitId lit : clause) {
+        std::uint32_t value = lit;
+        while (value > 0x7f) {
+            *out++ = static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<char>(value);
+    }
+    *out++ = 0;
+    return out;
+}
+
+char* ProofWriter::encode_text(char* out, char kind, std::span<const LitId> clause) {
+    if (kind == DELETE) {
+        *out++ = 'd';
+        *out++ = ' ';
+    }
+    for (LitId lit : clause) {
+        out = std::to_chars(out, out + MAX_LITERAL_BYTES, LitToDimacs(lit)).ptr;
+        *out++ = ' ';
+    }
+    *out++ = '0';
+    *out++ = '\n';
+    return out;
+}
+
+void ProofWriter::hand_over(std::size_t needed) {
+    Buffer next;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        full.push_back(std::move(current));
+        if (!spare.empty() && spare.back().capacity >= needed) {
+            next = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    queued.notify_one();
+
+    if (!next.data) {
+        next.capacity = std::max(BUFFER_SIZE, needed);
+        next.data = std::make_unique<char[]>(next.capacity);
+    }
+    next.size = 0;
+    current = std::move(next);
+}
+
+void ProofWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        queued.wait(lock, [this] { return closing || !full.empty(); });
+        if (full.empty()) {
+            return;
+        }
+        Buffer buffer = std::move(full.front());
+        full.pop_front();
+
+        lock.unlock();
+        if (buffer.size > 0 && std::fwrite(buffer.data.get(), 1, buffer.size, file) != buffer.size) {
+            failed = true;
+        }
+        buffer.size = 0;
+        lock.lock();
+
+        if (buffer.capacity == BUFFER_SIZE) {
+            spare.push_back(std::move(buffer));
+        }
+    }
+}
+
+}  // namespace NimmerSAT
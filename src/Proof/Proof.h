@@ -0,0 +1,119 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "NSatUtility.h"
+
+namespace NimmerSAT {
+
+enum class ProofFormat {
+    TEXT,     // DRAT as in the SAT competitions, "d" marks deletions
+    BINARY    // Binary DRAT, literals as variable length integers
+};
+
+// Writes a DRAT proof of unsatisfiability. Lemmas and deletions are encoded
+// into large buffers by the solver thread, and full buffers are written to
+// the file by a background thread. Buffers that have been written are
+// reused, and a new one is allocated when none is free, so the solver never
+// waits for the file.
+class ProofWriter final {
+public:
+
+    ProofWriter(const char* path, ProofFormat format);
+
+    ProofWriter(const ProofWriter&) = delete;
+    ProofWriter& operator=(const ProofWriter&) = delete;
+
+    // Finishes the proof if close() was not called.
+    ~ProofWriter();
+
+    // Whether the file could be opened.
+    inline bool is_open() const {
+        return file != nullptr;
+    }
+
+    inline void add(std::span<const LitId> clause) {
+        write(ADD, clause);
+    }
+
+    inline void remove(std::span<const LitId> clause) {
+        write(DELETE, clause);
+    }
+
+    // Writes everything still buffered and closes the file. Returns false
+    // if any write failed.
+    bool close();
+
+private:
+
+    constexpr static char ADD = 'a';
+    constexpr static char DELETE = 'd';
+
+    constexpr static std::size_t BUFFER_SIZE = std::size_t{4} << 20;
+
+    // Upper bound of the encoded size of a literal and of the framing of a
+    // clause in either format.
+    constexpr static std::size_t MAX_LITERAL_BYTES = 12;
+    constexpr static std::size_t MAX_FRAME_BYTES = 4;
+
+    struct Buffer {
+        std::unique_ptr<char[]> data;
+        std::size_t capacity = 0;
+        std::size_t size = 0;
+    };
+
+    inline void write(char kind, std::span<const LitId> clause) {
+        std::size_t needed = MAX_FRAME_BYTES + clause.size() * MAX_LITERAL_BYTES;
+        if (current.size + needed > current.capacity) {
+            hand_over(needed);
+        }
+        char* out = current.data.get() + current.size;
+        if (format == ProofFormat::BINARY) {
+            out = encode_binary(out, kind, clause);
+        } else {
+            out = encode_text(out, kind, clause);
+        }
+        current.size = static_cast<std::size_t>(out - current.data.get());
+    }
+
+    static char* encode_binary(char* out, char kind, std::span<const LitId> clause);
+
+    static char* encode_text(char* out, char kind, std::span<const LitId> clause);
+
+    // Queues the current buffer for writing and continues in one with room
+    // for at least needed bytes.
+    void hand_over(std::size_t needed);
+
+    void run();
+
+    ProofFormat format;
+
+    std::FILE* file = nullptr;
+
+    Buffer current;
+
+    std::mutex mutex;
+
+    std::condition_variable queued;
+
+    std::deque<Buffer> full;
+
+    std::vector<Buffer> spare;
+
+    bool closing = false;
+
+    bool failed = false;
+
+    std::thread writer;
+
+};
+
+}  // namespace NimmerSAT
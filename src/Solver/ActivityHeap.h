@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include <random>
+
+#include "NSatUtility.h"
+
+namespace NimmerSAT {
+
+// Indexed binary max-heap of variables ordered by activity. Every variable
+// knows its position in the heap, so membership tests are O(1) and bumping
+// or reinserting a variable is O(log n).
+class ActivityHeap final {
+public:
+
+    explicit ActivityHeap(std::uint32_t variable_count) :
+        activity(variable_count, 0.0),
+        position(variable_count, NOT_IN_HEAP)
+    {
+        heap.reserve(variable_count);
+        for (VarId var = 1; var <= variable_count; var++) {
+            insert(var);
+        }
+    }
+
+    ActivityHeap(const ActivityHeap&) = delete;
+    ActivityHeap(ActivityHeap&&) = default;
+
+    ActivityHeap& operator=(const ActivityHeap&) = delete;
+    ActivityHeap& operator=(ActivityHeap&&) = default;
+
+    ~ActivityHeap() = default;
+
+    // Adds variables up to variable_count with zero activity.
+    void grow(std::uint32_t variable_count) {
+        if (variable_count <= activity.size()) {
+            return;
+        }
+        VarId first = static_cast<VarId>(activity.size()) + 1;
+        activity.resize(variable_count, 0.0);
+        position.resize(variable_count, NOT_IN_HEAP);
+        for (VarId var = first; var <= variable_count; var++) {
+            insert(var);
+        }
+    }
+
+    // Starts over with variables up to variable_count at zero activity.
+    void reset(std::uint32_t variable_count) {
+        activity.assign(variable_count, 0.0);
+        position.assign(variable_count, NOT_IN_HEAP);
+        heap.clear();
+        increment = 1.0;
+        for (VarId var = 1; var <= variable_count; var++) {
+            insert(var);
+        }
+    }
+
+    inline bool empty() const {
+        return heap.empty();
+    }
+
+    inline bool contains(VarId var) const {
+        return position[var - 1] != NOT_IN_HEAP;
+    }
+
+    inline double var_activity(VarId var) const {
+        return activity[var - 1];
+    }
+
+    inline void insert(VarId var) {
+        if (contains(var)) {
+            return;
+        }
+        position[var - 1] = static_cast<std::uint32_t>(heap.size());
+        heap.push_back(var);
+        sift_up(position[var - 1]);
+    }
+
+    inline VarId pop() {
+        VarId top = heap.front();
+        heap.front() = heap.back();
+        position[heap.front() - 1] = 0;
+        position[top - 1] = NOT_IN_HEAP;
+        heap.pop_back();
+        if (!heap.empty()) {
+            sift_down(0);
+        }
+        return top;
+    }
+
+    // Exponential VSIDS: instead of decaying every activity after a conflict
+    // the increment grows, and everything is rescaled before it overflows.
+    inline void bump(VarId var) {
+        if ((activity[var - 1] += increment) > RESCALE_LIMIT) {
+            for (double &a : activity) {
+                a *= 1.0 / RESCALE_LIMIT;
+            }
+            increment *= 1.0 / RESCALE_LIMIT;
+        }
+        if (contains(var)) {
+            sift_up(position[var - 1]);
+        }
+    }
+
+    // Gives every variable a small random activity, so that the order of
+    // variables never bumped differs between seeds.
+    void randomize(std::uint64_t seed) {
+        std::mt19937_64 random(seed);
+        std::uniform_real_distribution<double> jitter(0.0, 1e-5);
+        for (double &a : activity) {
+            a += jitter(random);
+        }
+        std::vector<VarId> variables = std::move(heap);
+        heap.clear();
+        for (VarId var : variables) {
+            position[var - 1] = NOT_IN_HEAP;
+        }
+        for (VarId var : variables) {
+            insert(var);
+        }
+    }
+
+    inline void decay(double factor) {
+        increment *= 1.0 / factor;
+    }
+
+    void sanitize() const {
+        for (std::uint32_t i = 0; i < heap.size(); i++) {
+            if (position[heap[i] - 1] != i) {
+                std::stringstream str;
+                str << "Heap position of variable " << heap[i] << " is " << position[heap[i] - 1];
+                str << " Expected: " << i;
+                Error(str);
+            }
+            if (i > 0 && activity[heap[(i - 1) / 2] - 1] < activity[heap[i] - 1]) {
+                Error("Heap property violated");
+            }
+        }
+    }
+
+private:
+
+    constexpr static std::uint32_t NOT_IN_HEAP = std::numeric_limits<std::uint32_t>::max();
+    constexpr static double RESCALE_LIMIT = 1e100;
+
+    inline void sift_up(std::uint32_t index) {
+        VarId var = heap[index];
+        while (index > 0) {
+            std::uint32_t parent = (index - 1) / 2;
+            if (activity[heap[parent] - 1] >= activity[var - 1]) {
+                break;
+            }
+            heap[index] = heap[parent];
+            position[heap[index] - 1] = index;
+            index = parent;
+        }
+        heap[index] = var;
+        position[var - 1] = index;
+    }
+
+    inline void sift_down(std::uint32_t index) {
+        VarId var = heap[index];
+        std::uint32_t size = static_cast<std::uint32_t>(heap.size());
+        for (;;) {
+            std::uint32_t child = 2 * index + 1;
+            if (child >= size) {
+                break;
+            }
+            if (child + 1 < size && activity[heap[child + 1] - 1] > activity[heap[child] - 1]) {
+                child++;
+            }
+            if (activity[heap[child] - 1] <= activity[var - 1]) {
+                break;
+            }
+            heap[index] = heap[child];
+            position[heap[index] - 1] = index;
+            index = child;
+        }
+        heap[index] = var;
+        position[var - 1] = index;
+    }
+
+    double increment = 1.0;
+
+    std::vector<double> activity;
+
+    std::vector<std::uint32_t> position;
+
+    std::vector<VarId> heap;
+
+};
+
+}  // namespace NimmerSAT
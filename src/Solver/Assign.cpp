@@ -4,120 +4,345 @@
 
 namespace NimmerSAT {
 
-Solver::Solver(std::uint32_t variable_count, ClauseCache clause_cache) :
+template <typename Policy>
+BasicSolver<Policy>::BasicSolver(std::uint32_t variable_count, ClauseCache clause_cache, SolverOptions options) :
+    options(options),
     variables(variable_count),
-    clauses(std::move(clause_cache))
+    clauses(std::move(clause_cache)),
+    trail(variable_count),
+    seen(variable_count, false),
+    level_stamp(variable_count + 1, 0),
+    heap(variable_count),
+    restarts(options),
+    saved_phase(variable_count, options.initial_phase),
+    reduce_interval(options.reduce_first),
+    next_reduce(options.reduce_first),
+    literal_stamp(2 * (std::size_t{variable_count} + 1), 0),
+    equivalent(2 * (std::size_t{variable_count} + 1)),
+    model(2 * (std::size_t{variable_count} + 1), Value::UNASSIGNED)
 {
-    for (ClauseId clause_id = 0; clause_id < static_cast<ClauseId>(clauses.size()); clause_id++) {
-        const auto& current_clause = clauses[clause_id];
-        std::uint32_t clause_size = static_cast<std::uint32_t>(current_clause.literals.size());
-        
-        if (clause_size == 1) {
-            unit_queue.push_back(current_clause.literals[0]);
-        }
+    for (LitId lit = 0; lit < equivalent.size(); lit++) {
+        equivalent[lit] = lit;
+    }
 
-        for (std::uint32_t literal_pos = 0; literal_pos < clause_size; literal_pos++) {
-            LitId current_literal = current_clause.literals[literal_pos];
-            variables.observe(current_literal, ClauseLiteralIndex{clause_id, literal_pos});
-        }
+    if (options.seed != 0) {
+        heap.randomize(options.seed);
+    }
+    if (gaussian_elimination()) {
+        xors = FindXors(clauses, options.xor_max_size);
+        gauss_stale = !xors.empty();
     }
+    attach_clauses();
 }
 
-bool Solver::assign_literal(LitId lit, AssignmentType type) {
-    if constexpr (Debug()) {
-        if (type == AssignmentType::BRANCHED && variables.lit_val(lit) != Value::UNASSIGNED) {
-            std::stringstream str;
-            str << "BRANCH: " << lit << " but already assigned.";
-            Error(str);
+template <typename Policy>
+ClauseCache BasicSolver<Policy>::reset(std::uint32_t variable_count, ClauseCache clause_cache) {
+    ClauseCache previous = std::move(clauses);
+    previous.clear();
+    clauses = std::move(clause_cache);
+
+    std::size_t literal_count = 2 * (std::size_t{variable_count} + 1);
+    variables.reset(variable_count);
+    trail.reset(variable_count);
+    conflict_clause = NO_CLAUSE;
+    conflict_literal = 0;
+    binary_clause_count = 0;
+    learnt_clause.clear();
+    learnt_lbd = 0;
+    seen.assign(variable_count, false);
+    level_stamp.assign(variable_count + 1, 0);
+    current_stamp = 0;
+    heap.reset(variable_count);
+    if (options.seed != 0) {
+        heap.randomize(options.seed);
+    }
+    restarts = RestartScheduler<Policy>(options);
+    saved_phase.assign(variable_count, options.initial_phase);
+    conflicts = 0;
+    reduce_interval = options.reduce_first;
+    next_reduce = options.reduce_first;
+    clause_increment = 1.0;
+    literal_stamp.assign(literal_count, 0);
+    next_inprocess = 0;
+    probe_position = 1;
+    substituted.clear();
+    equivalent.resize(literal_count);
+    for (LitId lit = 0; lit < literal_count; lit++) {
+        equivalent[lit] = lit;
+    }
+    conflict_limit = NO_LIMIT;
+    propagations = 0;
+    propagation_limit = NO_LIMIT;
+    deadline = NO_DEADLINE;
+    memory_limit = NO_LIMIT;
+    budget_countdown = BUDGET_CHECK_INTERVAL;
+    interrupt_requested.store(false, std::memory_order_relaxed);
+    best_assignment.clear();
+    best_shared = 0;
+    formula_unsatisfiable = false;
+    conflicting_units = false;
+    interrupted = false;
+    model.assign(literal_count, Value::UNASSIGNED);
+    failed_literals.clear();
+    stats = {};
+    next_local_search = 0;
+    local_search_rounds = 0;
+    local_search_stale = true;
+    gauss.clear();
+    xors.clear();
+    gauss_stale = false;
+    if (gaussian_elimination()) {
+        xors = FindXors(clauses, options.xor_max_size);
+        gauss_stale = !xors.empty();
+    }
+
+    attach_clauses();
+    return previous;
+}
+
+template <typename Policy>
+void BasicSolver<Policy>::attach_clauses() {
+    for (ClauseId clause_id : clauses) {
+        Clause current_clause = clauses[clause_id];
+
+        if (current_clause.size() == 0) {
+            conflicting_units = true;
+            clauses.remove(clause_id);
+            continue;
         }
-        if (variables.lit_val(lit) == Value::FALSE) {
-            std::stringstream str;
-            str << "Literal " << lit << " already set to false.";
-            Error(str);
+
+        if (current_clause.size() == 1) {
+            LitId unit = current_clause[0];
+            if (variables.lit_val(unit) == Value::UNASSIGNED) {
+                assign(unit, clause_id);
+            } else if (variables.lit_val(unit) == Value::FALSE) {
+                conflicting_units = true;
+            }
+            continue;
         }
+
+        // Binary clauses only live in the implication lists.
+        if (current_clause.size() == 2) {
+            variables.add_binary(current_clause[0], current_clause[1]);
+            binary_clause_count++;
+            clauses.remove(clause_id);
+            continue;
+        }
+
+        variables.watch(current_clause[0], Watcher{clause_id, current_clause[1]});
+        variables.watch(current_clause[1], Watcher{clause_id, current_clause[0]});
     }
 
-    if (variables.lit_val(lit) == Value::TRUE) {
-        return true;
+    if (clauses.wasted() > 0) {
+        collect_garbage();
     }
+}
 
-    assignment_stack.push_back(Assignment{type, lit});
-    variables.set_lit(lit);
+template <typename Policy>
+bool BasicSolver<Policy>::add_clause(std::span<const LitId> literals) {
+    if (formula_unsatisfiable) {
+        return false;
+    }
+    if (trail.level() > 0) {
+        backjump(0);
+    }
+    if (!unit_prop() || !add_simplified(literals, false, 0)) {
+        refute();
+        return false;
+    }
+    return true;
+}
 
-    for (const auto &clause_literal : variables.lit_pos_occ(lit)) {
-        auto &clause = clauses[clause_literal.first];
-        clause.active_literal_count--;
-        if (clause.satisfied_index == Clause::UNSATISFIED) {
-            clause.satisfied_index = clause_literal.second;
+template <typename Policy>
+void BasicSolver<Policy>::reserve_variables(std::uint32_t variable_count) {
+    if (variable_count <= variables.variable_count()) {
+        return;
+    }
+    std::size_t literal_count = 2 * (std::size_t{variable_count} + 1);
+    variables.resize(variable_count);
+    trail.grow(variable_count);
+    seen.resize(variable_count, false);
+    level_stamp.resize(variable_count + 1, 0);
+    heap.grow(variable_count);
+    saved_phase.resize(variable_count, options.initial_phase);
+    literal_stamp.resize(literal_count, 0);
+    for (LitId lit = static_cast<LitId>(equivalent.size()); lit < literal_count; lit++) {
+        equivalent.push_back(lit);
+    }
+    model.resize(literal_count, Value::UNASSIGNED);
+    local_search_stale = true;
+}
+
+template <typename Policy>
+std::uint64_t BasicSolver<Policy>::memory_usage() const {
+    // Per variable: two literal values, level, reason, trail entry, saved
+    // phase and seen flag, heap activity and position, and per literal a
+    // watch list, an implication list, a stamp and a representative.
+    constexpr std::uint64_t PER_VARIABLE = 2 * sizeof(Value) + sizeof(std::uint32_t) + sizeof(ClauseId) +
+        sizeof(LitId) + 1 + sizeof(double) + 2 * sizeof(std::uint32_t) +
+        2 * (sizeof(std::vector<Watcher>) + sizeof(std::vector<LitId>) + sizeof(std::uint64_t) + sizeof(LitId));
+    return clauses.memory_words() * sizeof(LitId) +
+        clauses.size() * 2 * sizeof(Watcher) +
+        binary_clause_count * 2 * sizeof(LitId) +
+        std::uint64_t{variables.variable_count()} * PER_VARIABLE +
+        gauss.memory_usage();
+}
+
+template <typename Policy>
+void BasicSolver<Policy>::store_model() {
+    model.resize(2 * (std::size_t{variables.variable_count()} + 1));
+    for (LitId lit = 0; lit < model.size(); lit++) {
+        model[lit] = variables.lit_val(lit);
+    }
+    substituted.extend(model);
+}
+
+template <typename Policy>
+void BasicSolver<Policy>::analyze_final(LitId lit) {
+    failed_literals.push_back(lit);
+    if (variables.var_level(LitToVar(lit)) == 0) {
+        return;
+    }
+
+    // Every decision on the trail is an assumption, so the decisions the
+    // negation of lit depends on are the failed assumptions. Level 0
+    // literals are never marked, also where they were assigned out of order.
+    std::array<LitId, 2> binary;
+    seen[LitToVar(lit) - 1] = true;
+    for (std::size_t i = trail.size(); i-- > trail.level_start(1);) {
+        LitId assigned = trail[i];
+        VarId var = LitToVar(assigned);
+        if (!seen[var - 1]) {
+            continue;
         }
+        seen[var - 1] = false;
+        if (ClauseId reason = variables.var_reason(var); reason == NO_CLAUSE) {
+            failed_literals.push_back(assigned);
+        } else {
+            for (LitId other : reason_clause(reason, assigned, binary)) {
+                if (other != assigned && variables.var_level(LitToVar(other)) > 0) {
+                    seen[LitToVar(other) - 1] = true;
+                }
+            }
+        }
+    }
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::propagate(LitId lit) {
+    // Literals implied by clauses whose other literals are all false are
+    // assigned at the highest level among those. That is the current level
+    // unless lit was assigned out of order, below it.
+    std::uint32_t level = variables.var_level(LitToVar(lit));
+    bool in_order = level == trail.level();
 
-        if constexpr (Debug()) {
-            clause.sanitize();
+    // Binary implications are handled first and never touch the arena.
+    for (LitId implied : variables.binaries(lit)) {
+        Value value = variables.lit_val(implied);
+        if (value == Value::FALSE) {
+            conflict_clause = BinaryReason(Neg(lit));
+            conflict_literal = implied;
+            return false;
+        }
+        if (value == Value::UNASSIGNED) {
+            assign(implied, BinaryReason(Neg(lit)), level);
         }
     }
 
+    // Only clauses watching the now false literal need to be visited.
+    LitId false_lit = Neg(lit);
+    auto &watchers = variables.watches(false_lit);
+    std::size_t read = 0;
+    std::size_t write = 0;
+    std::size_t watcher_count = watchers.size();
     bool conflict_detected = false;
-    for (const auto &clause_literal : variables.lit_neg_occ(lit)) {
-        auto &clause = clauses[clause_literal.first];
-        clause.active_literal_count--;
-        if (!clause.satisfied()) {
-            switch(clause.active_literals()) {
-                case 0:
-                    conflict_detected = true;
-                    break;
-
-                case 1:
-                    if (!conflict_detected) {
-                        for (LitId lit : clause.literals) {
-                            if (variables.lit_val(lit) == Value::UNASSIGNED) {
-                                unit_queue.push_back(lit);
-                                break;
-                            }
-                        }
-                    }
-                    break;
-            }
-        }
 
-        if constexpr (Debug()) {
-            clause.sanitize();
+    while (read < watcher_count) {
+        Watcher watcher = watchers[read++];
+        if (variables.lit_val(watcher.blocker) == Value::TRUE) {
+            watchers[write++] = watcher;
+            continue;
         }
 
-    }
-    return !conflict_detected;
-}
+        Clause literals = clauses[watcher.clause];
+        if (literals[0] == false_lit) {
+            std::swap(literals[0], literals[1]);
+        }
 
-void Solver::unassign(LitId lit) {
+        LitId first = literals[0];
+        if (first != watcher.blocker && variables.lit_val(first) == Value::TRUE) {
+            watchers[write++] = Watcher{watcher.clause, first};
+            continue;
+        }
 
-    for (auto &clause_literal : variables.lit_pos_occ(lit)) {
-        auto &clause = clauses[clause_literal.first];
-        clause.active_literal_count++;
-        if (clause.satisfied_index == clause_literal.second) {
-            clause.satisfied_index = Clause::UNSATISFIED;
+        bool found_watch = false;
+        for (std::uint32_t k = 2; k < literals.size(); k++) {
+            if (variables.lit_val(literals[k]) != Value::FALSE) {
+                std::swap(literals[1], literals[k]);
+                variables.watch(literals[1], Watcher{watcher.clause, first});
+                found_watch = true;
+                break;
+            }
+        }
+        if (found_watch) {
+            continue;
         }
 
-        if constexpr (Debug()) {
-            clause.sanitize();
+        watchers[write++] = Watcher{watcher.clause, first};
+        if (variables.lit_val(first) == Value::FALSE) {
+            conflict_detected = true;
+            conflict_clause = watcher.clause;
+            while (read < watcher_count) {
+                watchers[write++] = watchers[read++];
+            }
+        } else {
+            assign(first, watcher.clause, in_order ? level : implication_level(literals.literals()));
         }
     }
+    watchers.resize(write);
+    if (conflict_detected || !gauss_active()) {
+        return !conflict_detected;
+    }
 
-    for (auto &clause_literal : variables.lit_neg_occ(lit)) {
-        auto &clause = clauses[clause_literal.first];
-        clause.active_literal_count++;
-
-        if constexpr(Debug()) {
-            clause.sanitize();
+    // Gaussian elimination takes lit from the same queue. Its implications
+    // can combine rows whose variables were all assigned below the current
+    // level.
+    bool consistent = gauss.propagate(LitToVar(lit));
+    for (LitId implied : gauss.implied()) {
+        assign(implied, XOR_REASON, implication_level(gauss.reason(LitToVar(implied))));
+    }
+    if constexpr (Stats()) {
+        stats.xor_implications += gauss.implied().size();
+    }
+    if (!consistent) {
+        if constexpr (Stats()) {
+            stats.xor_conflicts++;
         }
+        conflict_clause = XOR_CONFLICT;
+        conflict_literal = gauss.conflict()[0];
     }
+    return consistent;
+}
 
+template <typename Policy>
+void BasicSolver<Policy>::unassign(LitId lit) {
     variables.unset_lit(lit);
+    if (gauss_active()) {
+        gauss.unset(LitToVar(lit));
+    }
+    if (phase_saving()) {
+        saved_phase[LitToVar(lit) - 1] = IsPositive(lit);
+    }
+    if (decision_heuristic() == DecisionHeuristic::VSIDS) {
+        heap.insert(LitToVar(lit));
+    }
 }
 
-void Solver::sanitize() const {
+template <typename Policy>
+void BasicSolver<Policy>::sanitize() const {
 
     std::vector<bool> is_already_stacked(variables.variable_count(), false);
-    for (const auto &assignemnt : assignment_stack) {
-        LitId lit = assignemnt.literal;
+    for (LitId lit : trail) {
         if (is_already_stacked.at(LitToVar(lit) - 1) == true) {
             std::stringstream str;
             str << "Variable " << LitToVar(lit) << " twice in stack.";
@@ -126,7 +351,7 @@ void Solver::sanitize() const {
         is_already_stacked[LitToVar(lit) - 1] = true;
         if (variables.lit_val(lit) != Value::TRUE) {
             std::stringstream str;
-            str << "Value on stack does not match assigned value" << lit;
+            str << "Value on stack does not match assigned value" << LitToDimacs(lit);
             Error(str);
         }
     }
@@ -139,43 +364,166 @@ void Solver::sanitize() const {
         }
     }
 
-    if (assignment_stack.size() > variables.variable_count()) {
+    if (trail.size() > variables.variable_count()) {
         std::stringstream str;
-        str << "Assignment stack size: " << assignment_stack.size();
+        str << "Trail size: " << trail.size();
         str << " Variable count: " << variables.variable_count();
         Error(str);
     }
 
-    if (unit_queue.size() > clauses.size()) {
+    if (best_shared > std::min(trail.size(), best_assignment.size()) ||
+        !std::equal(best_assignment.begin(), best_assignment.begin() + best_shared, trail.begin())) {
         std::stringstream str;
-        str << "Unit queue size: " << unit_queue.size();
-        str << " Clause count: " << clauses.size();
+        str << "Best assignment shares no prefix of " << best_shared << " literals with the trail";
         Error(str);
     }
 
-    for (const auto& clause : clauses) {
-        std::uint32_t check_active_literal_count = 0;
-        for (LitId lit : clause.literals) {
-            if (variables.lit_val(lit) == Value::UNASSIGNED) {
-                check_active_literal_count++;
-            }
+    std::uint32_t level = 0;
+    for (std::size_t i = 0; i < trail.size(); i++) {
+        while (level < trail.level() && trail.level_start(level + 1) == i) {
+            level++;
+        }
+        // Levels of assumptions that were true already have no decision, so
+        // the first literal of a level can also be implied.
+        VarId var = LitToVar(trail[i]);
+        bool decision = level > 0 && variables.var_reason(var) == NO_CLAUSE;
+        if (decision ? variables.var_level(var) != level : variables.var_level(var) > level) {
+            std::stringstream str;
+            str << "Variable " << var << " has level " << variables.var_level(var);
+            str << " but is stacked at level " << level;
+            Error(str);
+        }
+        if (decision && i != trail.level_start(level)) {
+            std::stringstream str;
+            str << "Decision " << LitToDimacs(trail[i]) << " does not start its level";
+            Error(str);
         }
 
-        if (check_active_literal_count != clause.active_literals()) {
+        // Above level 0 the reason of an implied literal starts with it, its
+        // other literals are false and the highest level among them is the
+        // level of the implied literal.
+        ClauseId reason = variables.var_reason(var);
+        if (decision || variables.var_level(var) == 0 || reason == NO_CLAUSE) {
+            continue;
+        }
+        std::array<LitId, 2> binary;
+        std::span<const LitId> literals = reason_clause(reason, trail[i], binary);
+        std::uint32_t highest = 0;
+        for (LitId other : literals.subspan(1)) {
+            if (variables.lit_val(other) != Value::FALSE) {
+                std::stringstream str;
+                str << "Reason of " << LitToDimacs(trail[i]) << " has " << LitToDimacs(other) << " not false";
+                Error(str);
+            }
+            highest = std::max(highest, variables.var_level(LitToVar(other)));
+        }
+        if (literals[0] != trail[i] || highest != variables.var_level(var)) {
             std::stringstream str;
-            str << "Active literal count does not match: ";
-            str << "Expected: " << check_active_literal_count << " Got: " << clause.active_literals();
+            str << "Implied " << LitToDimacs(trail[i]) << " has level " << variables.var_level(var);
+            str << " but its reason has level " << highest;
             Error(str);
         }
+    }
 
-        if (clause.satisfied_index != Clause::UNSATISFIED) {
-            if (variables.lit_val(clause.literals[clause.satisfied_index]) != Value::TRUE) {
+    if (level != trail.level()) {
+        std::stringstream str;
+        str << "Decision level: " << trail.level() << " Levels on trail: " << level;
+        Error(str);
+    }
+
+    if (trail.propagated() > trail.size()) {
+        std::stringstream str;
+        str << "Propagation head: " << trail.propagated() << " Trail size: " << trail.size();
+        Error(str);
+    }
+
+    if (decision_heuristic() == DecisionHeuristic::VSIDS) {
+        heap.sanitize();
+        for (VarId i = 1; i <= variables.variable_count(); i++) {
+            if (variables.var_val(i) == Value::UNASSIGNED && !heap.contains(i)) {
                 std::stringstream str;
-                str << "Clause satisfied index is not correct";
+                str << "Unassigned variable " << i << " missing from heap";
                 Error(str);
             }
         }
     }
+
+    if (gauss_active()) {
+        gauss.sanitize(variables);
+    }
+
+    std::vector<std::uint32_t> watch_count(clauses.memory_words(), 0);
+    for (VarId i = 1; i <= variables.variable_count(); i++) {
+        for (LitId lit : {VarToLit(i, true), VarToLit(i, false)}) {
+            for (const auto &watcher : variables.watches(lit)) {
+                const Clause clause = clauses[watcher.clause];
+                if (clause[0] != lit && clause[1] != lit) {
+                    std::stringstream str;
+                    str << "Clause " << watcher.clause << " watched by " << LitToDimacs(lit);
+                    str << " which is not one of its first two literals";
+                    Error(str);
+                }
+                watch_count.at(watcher.clause)++;
+            }
+        }
+    }
+
+    for (ClauseId clause_id : clauses) {
+        const Clause clause = clauses[clause_id];
+        clause.sanitize();
+        std::uint32_t expected = clause.size() == 1 || clause.deleted() ? 0 : 2;
+        if (watch_count[clause_id] != expected) {
+            std::stringstream str;
+            str << "Clause " << clause_id << " has " << watch_count[clause_id];
+            str << " watches. Expected: " << expected;
+            Error(str);
+        }
+    }
 }
 
+template <typename Policy>
+void BasicSolver<Policy>::collect_garbage() {
+    clauses.collect([this](auto relocated) {
+        for (VarId i = 1; i <= variables.variable_count(); i++) {
+            for (LitId lit : {VarToLit(i, true), VarToLit(i, false)}) {
+                auto &watchers = variables.watches(lit);
+                std::size_t write = 0;
+                for (Watcher watcher : watchers) {
+                    if (ClauseId clause = relocated(watcher.clause); clause != NO_CLAUSE) {
+                        watchers[write++] = Watcher{clause, watcher.blocker};
+                    }
+                }
+                watchers.resize(write);
+            }
+        }
+
+        for (LitId lit : trail) {
+            VarId var = LitToVar(lit);
+            ClauseId reason = variables.var_reason(var);
+            if (reason != NO_CLAUSE && !IsBinaryReason(reason) && !IsXorReason(reason)) {
+                variables.set_reason(var, relocated(reason));
+            }
+        }
+    });
+}
+
+
+#define INSTANTIATE(Policy) \
+    template BasicSolver<Policy>::BasicSolver(std::uint32_t variable_count, ClauseCache clause_cache, SolverOptions options); \
+    template ClauseCache BasicSolver<Policy>::reset(std::uint32_t variable_count, ClauseCache clause_cache); \
+    template void BasicSolver<Policy>::attach_clauses(); \
+    template bool BasicSolver<Policy>::add_clause(std::span<const LitId> literals); \
+    template void BasicSolver<Policy>::reserve_variables(std::uint32_t variable_count); \
+    template std::uint64_t BasicSolver<Policy>::memory_usage() const; \
+    template void BasicSolver<Policy>::store_model(); \
+    template void BasicSolver<Policy>::analyze_final(LitId lit); \
+    template bool BasicSolver<Policy>::propagate(LitId lit); \
+    template void BasicSolver<Policy>::unassign(LitId lit); \
+    template void BasicSolver<Policy>::sanitize() const; \
+    template void BasicSolver<Policy>::collect_garbage();
+
+NIMMERSAT_FOR_EACH_POLICY(INSTANTIATE)
+
+#undef INSTANTIATE
+
 }  // namespace NimmerSAT
@@ -1,133 +1,820 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
-#include <deque>
+#include <functional>
+#include <algorithm>
 #include <vector>
 #include <stack>
 #include <optional>
+#include <array>
+#include <span>
+#include <limits>
 
 #include "Formula/VariableCache.h"
 #include "Formula/FormulaCache.h"
+#include "Preprocess/Reconstruction.h"
+#include "Proof/Proof.h"
 #include "NSatUtility.h"
+#include "ActivityHeap.h"
+#include "Exchange.h"
+#include "Gauss.h"
+#include "LocalSearch.h"
+#include "Options.h"
+#include "Policy.h"
+#include "Restart.h"
+#include "Stack.h"
+#include "Statistics.h"
 
 #include <iostream>
 
 namespace NimmerSAT {
 
-class Solver final {
+enum class SolveResult {
+    SATISFIABLE,
+    UNSATISFIABLE,
+    UNKNOWN   // Terminated from outside before an answer was found
+};
+
+// The settings fixed by Policy replace the corresponding options, see
+// Policy.h. The member functions are compiled for the policies listed in
+// NIMMERSAT_FOR_EACH_POLICY only.
+template <typename Policy>
+class BasicSolver final {
 public:
 
-    explicit Solver(std::uint32_t variable_count, ClauseCache clauses);
+    explicit BasicSolver(std::uint32_t variable_count, ClauseCache clauses, SolverOptions options = {});
 
-    Solver(const Solver&) = delete;
-    Solver(Solver&&) = default;
-    Solver& operator=(const Solver&) = delete;
-    Solver& operator=(Solver&&) = default;
-    ~Solver() = default;
+    BasicSolver(const BasicSolver&) = delete;
+    BasicSolver(BasicSolver&&) = delete;
+    BasicSolver& operator=(const BasicSolver&) = delete;
+    BasicSolver& operator=(BasicSolver&&) = delete;
+    ~BasicSolver() = default;
 
-    bool solve() {
+    // Solves under the given assumptions, which are decided before any
+    // other variable. UNSATISFIABLE without inconsistent() means the
+    // formula has no model satisfying the assumptions. The solver can be
+    // called again, keeping its learnt clauses, also after it returned
+    // UNKNOWN because of its budget or an interrupt.
+    SolveResult solve(std::span<const LitId> assumptions = {}) {
+        failed_literals.clear();
+        interrupted = false;
+        if (formula_unsatisfiable) {
+            return SolveResult::UNSATISFIABLE;
+        }
+        if (trail.level() > 0) {
+            backjump(0);
+        }
+        bool conflict = (gauss_stale && !build_gauss()) || !unit_prop();
+        if (!conflict && options.inprocessing && conflicts >= next_inprocess) {
+            next_inprocess = conflicts + options.inprocess_interval;
+            if constexpr (Stats()) {
+                stats.inprocessings++;
+            }
+            conflict = !inprocess();
+        }
+        if (!conflict && options.local_search && conflicts >= next_local_search) {
+            next_local_search = conflicts + options.local_search_interval;
+            local_search(options.local_search_flips);
+        }
         for(;;) {
             if constexpr(Debug()) {
                 sanitize();
             }
 
             //print_unit();
-            if (!unit_prop()) {
+            if (conflict) {
                 //print_stack();
-                backtrack();
-                if (assignment_stack.empty()) {
-                    return false;
-                }
-                LitId top_lit = assignment_stack.back().literal;
-                unassign(top_lit);
-                assignment_stack.pop_back();
-                assign_literal(-top_lit, AssignmentType::FORCED);
+                if (trail.level() == 0) {
+                    return refute();
+                }
+                if (!backtrack_to_conflict()) {
+                    conflict = !unit_prop();
+                    continue;
+                }
+                if (trail.level() == 0) {
+                    return refute();
+                }
+                std::uint32_t jump_level = analyze();
+                backjump(backtrack_level(jump_level));
+                learn(jump_level);
+                conflicts++;
+                if (terminate_callback && terminate_callback()) {
+                    interrupted = true;
+                }
+                if constexpr (Stats()) {
+                    if (progress_callback && conflicts % progress_interval == 0) {
+                        progress_callback(statistics());
+                    }
+                }
+                heap.decay(options.var_decay);
+                clause_increment *= 1.0 / options.clause_decay;
+                restarts.on_conflict(learnt_lbd);
                 //variables.print();
+                conflict = !unit_prop();
             } else {
-                if (!branch()) {
-                    return true;
+                if (trail.size() > best_assignment.size()) {
+                    // The snapshot shares a prefix with the trail and only
+                    // the rest is copied, which keeps the copying within
+                    // the number of assignments.
+                    best_assignment.resize(best_shared);
+                    best_assignment.insert(best_assignment.end(), trail.begin() + best_shared, trail.end());
+                    best_shared = trail.size();
+                }
+                if (interrupted || out_of_budget() ||
+                    (terminate != nullptr && terminate->load(std::memory_order_relaxed))) {
+                    return SolveResult::UNKNOWN;
                 }
+                if (restarts.should_restart()) {
+                    restarts.on_restart();
+                    backjump(0);
+                    if (options.inprocessing && conflicts >= next_inprocess) {
+                        next_inprocess = conflicts + options.inprocess_interval;
+                        if constexpr (Stats()) {
+                            stats.inprocessings++;
+                        }
+                        if (!inprocess()) {
+                            return refute();
+                        }
+                    }
+                    if (options.local_search && conflicts >= next_local_search) {
+                        next_local_search = conflicts + options.local_search_interval;
+                        local_search(options.local_search_flips);
+                    }
+                }
+                if (exchange != nullptr && trail.level() == 0 && !import_shared()) {
+                    return refute();
+                }
+                if (conflicts >= next_reduce) {
+                    reduce_interval += options.reduce_increment;
+                    next_reduce = conflicts + reduce_interval;
+                    reduce_db();
+                }
+
+                // Assumption i is decided at level i + 1, as in MiniSat, so
+                // the next one to decide is found by the level. Those that
+                // are already true get a level without a decision.
+                std::optional<LitId> decision;
+                while (trail.level() < assumptions.size()) {
+                    LitId lit = equivalent[assumptions[trail.level()]];
+                    if (variables.lit_val(lit) == Value::FALSE) {
+                        analyze_final(lit);
+                        return SolveResult::UNSATISFIABLE;
+                    }
+                    if (variables.lit_val(lit) == Value::UNASSIGNED) {
+                        decision = lit;
+                        break;
+                    }
+                    trail.new_level();
+                }
+                if (!decision) {
+                    decision = branch();
+                }
+                if (!decision) {
+                    store_model();
+                    return SolveResult::SATISFIABLE;
+                }
+                if constexpr (Stats()) {
+                    stats.decisions++;
+                }
+                decide(*decision);
+                conflict = !unit_prop();
             }
         }
-   }
+    }
+
+    // Runs local search alone from the saved phases for at most max_flips
+    // flips. Returns SATISFIABLE with a model, UNSATISFIABLE if the formula
+    // is refuted at level 0 and UNKNOWN otherwise.
+    SolveResult solve_local(std::uint64_t max_flips);
+
+    // Starts over on another formula, as if newly constructed with the same
+    // options, callbacks and connections. The memory of the trail, the
+    // watch lists and the other per variable arrays is reused. Returns the
+    // arena of the previous formula, emptied, so that the caller can fill
+    // it with the next one.
+    ClauseCache reset(std::uint32_t variable_count, ClauseCache clauses);
+
+    // Adds a clause between calls of solve(). Returns false once the
+    // formula is unsatisfiable.
+    bool add_clause(std::span<const LitId> literals);
+
+    // Adds unassigned variables up to variable_count.
+    void reserve_variables(std::uint32_t variable_count);
+
+    inline std::uint32_t variable_count() const {
+        return variables.variable_count();
+    }
+
+    // Value of lit in the model found by the last successful solve().
+    inline Value model_value(LitId lit) const {
+        return model[lit];
+    }
+
+    // Whether the assumption lit was used to refute the assumptions of the
+    // last unsuccessful solve().
+    inline bool failed(LitId lit) const {
+        return std::find(failed_literals.begin(), failed_literals.end(), equivalent[lit]) != failed_literals.end();
+    }
+
+    // solve() returns UNKNOWN at the next conflict after callback returns
+    // true.
+    inline void set_terminate_callback(std::function<bool()> callback) {
+        terminate_callback = std::move(callback);
+    }
+
+    // Called with every learnt clause up to max_size literals.
+    inline void set_learn_callback(std::uint32_t max_size, std::function<void(std::span<const LitId>)> callback) {
+        learn_limit = max_size;
+        learn_callback = std::move(callback);
+    }
+
+    // Counters of all solve() calls so far, all zero but conflicts,
+    // propagations and restarts unless Stats().
+    inline SearchStatistics statistics() const {
+        SearchStatistics current = stats;
+        current.conflicts = conflicts;
+        current.propagations = propagations;
+        current.restarts = restarts.restart_count();
+        return current;
+    }
+
+    // Called with the statistics after every interval conflicts, unless
+    // statistics are compiled out.
+    inline void set_progress_callback(std::uint64_t interval,
+                                      std::function<void(const SearchStatistics&)> callback) {
+        progress_interval = std::max<std::uint64_t>(interval, 1);
+        progress_callback = std::move(callback);
+    }
+
+    // Whether the formula itself was found unsatisfiable.
+    inline bool inconsistent() const {
+        return formula_unsatisfiable;
+    }
+
+    // solve() returns UNKNOWN after this many further conflicts.
+    inline void set_conflict_budget(std::uint64_t budget) {
+        conflict_limit = budget == NO_LIMIT ? NO_LIMIT : conflicts + budget;
+    }
+
+    // solve() returns UNKNOWN after this many further assignments.
+    inline void set_propagation_budget(std::uint64_t budget) {
+        propagation_limit = budget == NO_LIMIT ? NO_LIMIT : propagations + budget;
+    }
+
+    // solve() returns UNKNOWN once this much time has passed from now.
+    inline void set_time_budget(double seconds) {
+        if (!(seconds < MAX_BUDGET_SECONDS)) {
+            deadline = NO_DEADLINE;
+            return;
+        }
+        deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(std::max(seconds, 0.0)));
+    }
+
+    // solve() returns UNKNOWN once memory_usage() exceeds bytes.
+    inline void set_memory_budget(std::uint64_t bytes) {
+        memory_limit = bytes;
+    }
+
+    inline void set_budget(const SolveBudget& budget) {
+        set_conflict_budget(budget.conflicts);
+        set_propagation_budget(budget.propagations);
+        set_time_budget(budget.seconds);
+        set_memory_budget(budget.memory_bytes);
+    }
+
+    // Makes the running solve() return UNKNOWN at its next decision, or the
+    // next call if none is running. May be called from any thread.
+    inline void interrupt() {
+        interrupt_requested.store(true, std::memory_order_relaxed);
+    }
+
+    // Bytes taken by the clauses, the watchers and the per variable arrays,
+    // estimated from their sizes.
+    std::uint64_t memory_usage() const;
+
+    // The largest assignment the search has reached without a conflict, on
+    // the variables of this solver. After an UNKNOWN answer it is the best
+    // partial assignment found so far.
+    inline std::span<const LitId> partial_assignment() const {
+        return best_assignment;
+    }
+
+    // Splits the formula under prefix into cubes by lookahead, each one
+    // extending prefix by up to depth literals. Cubes found unsatisfiable
+    // while splitting are left out, so an empty result means prefix is
+    // refuted.
+    std::vector<std::vector<LitId>> split(std::span<const LitId> prefix, std::uint32_t depth);
+
+    // solve() returns UNKNOWN soon after flag is set.
+    inline void set_terminate(const std::atomic<bool>* flag) {
+        terminate = flag;
+    }
+
+    // Shares learnt clauses with the other solvers of a portfolio, in which
+    // this solver has the given index.
+    inline void connect(ClauseExchange& clause_exchange, std::uint32_t index) {
+        exchange = &clause_exchange;
+        exchange_index = index;
+    }
+
+    // Records learnt and deleted clauses as a DRAT proof. Only supported
+    // for a solver that is neither given assumptions nor connected to a
+    // portfolio, since the lemmas of those are not implied by its formula
+    // alone. Ignored unless Policy::proof. Turns off Gaussian elimination.
+    inline void set_proof(ProofWriter* writer) {
+        proof = writer;
+        if (logging()) {
+            gauss.clear();
+        }
+    }
 
-    inline void print() const {
-        variables.print();        
+    // Assigns the variables removed by preprocessing and by equivalent
+    // literal substitution after a model was found.
+    inline void extend_model(const ModelReconstruction& reconstruction) {
+        reconstruction.extend(model);
+    }
+
+    void print() const {
+        std::cout << "VARS: ";
+        for (VarId var = 1; var <= variables.variable_count(); var++) {
+            switch (model[VarToLit(var, true)]) {
+                case Value::TRUE:
+                    std::cout << ' ' << var << ' ';
+                    break;
+
+                case Value::FALSE:
+                    std::cout << -static_cast<std::int32_t>(var) << ' ';
+                    break;
+
+                case Value::UNASSIGNED:
+                    std::cout << 'x' << var << ' ';
+                    break;
+            }
+        }
+        std::cout << std::endl;
     }
 
 private:
 
+    // Drives decide, unit_prop and backjump directly to measure
+    // propagation apart from the search, see benchmarks/Propagation.cpp.
+    friend class PropagationBenchmark;
+
     void print_unit() const {
-        if (!unit_queue.empty()) {
+        if (trail.pending()) {
             std::cout << "UNIT: ";
-            for (LitId l : unit_queue) { std::cout << l << ' '; }
+            for (std::size_t i = trail.propagated(); i < trail.size(); i++) {
+                std::cout << LitToDimacs(trail[i]) << ' ';
+            }
             std::cout << std::endl;
         }
     }
 
     void print_stack() const {
         std::cout << "BACK: ";
-        for (const auto &ass : assignment_stack) {
-            std::cout << ass.literal 
-                    << (ass.type == AssignmentType::FORCED ? "F" : "B") << ' ';
+        std::uint32_t level = 0;
+        for (std::size_t i = 0; i < trail.size(); i++) {
+            while (level < trail.level() && trail.level_start(level + 1) == i) {
+                std::cout << "| ";
+                level++;
+            }
+            std::cout << LitToDimacs(trail[i]) << ' ';
         }
         std::cout << std::endl;
     }
 
-    enum class AssignmentType {
-        FORCED,
-        BRANCHED
-    };
+    // Assigns lit at level and appends it to the trail, where it waits to
+    // be propagated. Implied literals are assigned at the highest level of
+    // the other literals of their reason, which is below the current level
+    // after chronological backtracking.
+    inline void assign(LitId lit, ClauseId reason, std::uint32_t level) {
+        if constexpr (Debug()) {
+            if (variables.lit_val(lit) != Value::UNASSIGNED) {
+                std::stringstream str;
+                str << "ASSIGN: " << LitToDimacs(lit) << " but already assigned.";
+                Error(str);
+            }
+        }
+        variables.set_lit(lit, level, reason);
+        if (gauss_active()) {
+            gauss.set(lit);
+        }
+        trail.push(lit);
+        propagations++;
+    }
+
+    inline void assign(LitId lit, ClauseId reason) {
+        assign(lit, reason, trail.level());
+    }
 
-    struct Assignment {
-        AssignmentType type;
-        LitId literal;
-    };
+    // Highest level among the literals of clause after the first.
+    inline std::uint32_t implication_level(std::span<const LitId> clause) const {
+        std::uint32_t level = 0;
+        for (LitId lit : clause.subspan(1)) {
+            level = std::max(level, variables.var_level(LitToVar(lit)));
+        }
+        return level;
+    }
 
-    bool assign_literal(LitId lit, AssignmentType type);
+    inline void decide(LitId lit) {
+        trail.new_level();
+        assign(lit, NO_CLAUSE);
+    }
+
+    // Assigns the literals implied by the true literal lit. Returns false
+    // on conflict, in which case conflict_clause is set. For binary
+    // conflicts conflict_literal is the literal that was implied.
+    bool propagate(LitId lit);
 
     inline bool unit_prop() {
-        while(!unit_queue.empty()) {
-            if (LitId lit = unit_queue.front(); 
-                !assign_literal(lit, AssignmentType::FORCED)) {
+        // Unit clauses of the formula contradicting each other, and empty
+        // clauses, are found before anything is on the trail.
+        if (conflicting_units) {
+            return false;
+        }
+        while (trail.pending()) {
+            if (!propagate(trail.next())) {
                 return false;
             }
-            unit_queue.pop_front();
         }
         return true;
     }
 
     void unassign(LitId lit);
 
-    inline void backtrack() {
-        while(!assignment_stack.empty() &&
-         assignment_stack.back().type == AssignmentType::FORCED) {
-            unassign(assignment_stack.back().literal);
-            assignment_stack.pop_back();
+    // Out of order assignments can leave every literal of the conflict
+    // clause below the current level. Backtracks to the highest level among
+    // them. If the clause has a single literal on that level, it was unit
+    // one level below, where that literal is assigned instead. Returns false
+    // in that case, as there is no conflict left to analyze.
+    bool backtrack_to_conflict();
+
+    // Derives the first UIP clause of conflict_clause into learnt_clause and
+    // returns the level at which it asserts its first literal.
+    std::uint32_t analyze();
+
+    // The level to backtrack to for a clause asserting at jump_level. Jumps
+    // over more than chrono_levels levels only go back one level, which
+    // keeps the assignments of the levels in between.
+    inline std::uint32_t backtrack_level(std::uint32_t jump_level) {
+        if (options.chrono_levels == 0 || trail.level() - jump_level <= options.chrono_levels) {
+            return jump_level;
+        }
+        if constexpr (Stats()) {
+            stats.chronological_backtracks++;
+        }
+        return trail.level() - 1;
+    }
+
+    // Checks whether a literal of the learnt clause is implied by the others.
+    bool redundant(LitId lit) const;
+
+    // Number of distinct decision levels among the literals.
+    std::uint32_t compute_lbd(std::span<const LitId> literals);
+
+    // Called for every learnt clause taking part in conflict analysis.
+    void bump_clause(ClauseId clause);
+
+    // Literals of a reason or conflict clause. Binary clauses are rebuilt
+    // from the implied literal and the tagged reason, those of Gaussian
+    // elimination are kept by the engine.
+    inline std::span<const LitId> reason_clause(ClauseId reason, LitId implied,
+                                                std::array<LitId, 2>& binary) const {
+        if (IsBinaryReason(reason)) {
+            binary = {implied, BinaryReasonLit(reason)};
+            return binary;
+        }
+        if (reason == XOR_REASON) {
+            return gauss.reason(LitToVar(implied));
+        }
+        if (reason == XOR_CONFLICT) {
+            return gauss.conflict();
         }
-        unit_queue.clear();
+        return clauses[reason].literals();
     }
 
-    inline bool branch() {
-        for (VarId i = 1; i <= variables.variable_count(); i++) {
-            if (variables.var_val(i) == Value::UNASSIGNED) {
-                assign_literal(VarToLit(i, true), AssignmentType::BRANCHED);
-                return true;
+    // A clause is locked while it is the reason of its first literal.
+    inline bool locked(ClauseId clause) const {
+        LitId first = clauses[clause][0];
+        return variables.lit_val(first) == Value::TRUE &&
+            variables.var_reason(LitToVar(first)) == clause;
+    }
+
+    // Deletes the less useful half of the local tier of learnt clauses.
+    void reduce_db();
+
+    // Adds learnt_clause to the formula and assigns its asserting literal
+    // at level.
+    void learn(std::uint32_t level);
+
+    // Adds the clauses published by other solvers at level 0. Returns false
+    // if the formula is unsatisfiable.
+    bool import_shared();
+
+    // Literals assigned out of order at level or below are kept.
+    inline void backjump(std::uint32_t level) {
+        if (level < trail.level()) {
+            best_shared = std::min(best_shared, trail.level_start(level + 1));
+        }
+        trail.backjump(level, [this, level](LitId lit) {
+            if (variables.var_level(LitToVar(lit)) <= level) {
+                return false;
             }
+            unassign(lit);
+            return true;
+        });
+    }
+
+    inline DecisionHeuristic decision_heuristic() const {
+        if constexpr (Policy::decision.has_value()) {
+            return *Policy::decision;
+        } else {
+            return options.decision;
         }
-        return false;
     }
 
-    void sanitize() const;
+    inline bool phase_saving() const {
+        if constexpr (Policy::phase_saving.has_value()) {
+            return *Policy::phase_saving;
+        } else {
+            return options.phase_saving;
+        }
+    }
+
+    inline bool gaussian_elimination() const {
+        if constexpr (Policy::gaussian_elimination.has_value()) {
+            return *Policy::gaussian_elimination;
+        } else {
+            return options.gaussian_elimination;
+        }
+    }
+
+    // Whether the engine has rows, false at compile time if the policy
+    // turns Gaussian elimination off.
+    inline bool gauss_active() const {
+        if constexpr (Policy::gaussian_elimination.has_value() && !*Policy::gaussian_elimination) {
+            return false;
+        } else {
+            return !gauss.empty();
+        }
+    }
+
+    // Whether lemmas are recorded, false at compile time unless
+    // Policy::proof.
+    inline bool logging() const {
+        return Policy::proof && proof != nullptr;
+    }
+
+    inline std::optional<LitId> branch() {
+        switch (decision_heuristic()) {
+            case DecisionHeuristic::SCAN:
+                for (VarId i = 1; i <= variables.variable_count(); i++) {
+                    if (variables.var_val(i) == Value::UNASSIGNED) {
+                        return VarToLit(i, saved_phase[i - 1]);
+                    }
+                }
+                break;
+
+            case DecisionHeuristic::VSIDS:
+                // Assigned variables are only removed lazily when they reach
+                // the top of the heap.
+                while (!heap.empty()) {
+                    if (VarId var = heap.pop(); variables.var_val(var) == Value::UNASSIGNED) {
+                        return VarToLit(var, saved_phase[var - 1]);
+                    }
+                }
+                break;
+        }
+        return std::nullopt;
+    }
+
+    // The clock and the memory estimate are only looked at every few calls,
+    // all other limits on every call.
+    inline bool out_of_budget() {
+        if (conflicts >= conflict_limit || propagations >= propagation_limit) {
+            return true;
+        }
+        if (interrupt_requested.load(std::memory_order_relaxed) &&
+            interrupt_requested.exchange(false, std::memory_order_relaxed)) {
+            return true;
+        }
+        if (--budget_countdown > 0) {
+            return false;
+        }
+        budget_countdown = BUDGET_CHECK_INTERVAL;
+        return (deadline != NO_DEADLINE && Clock::now() >= deadline) || memory_usage() > memory_limit;
+    }
+
+    // Assigns the unit clauses, moves the binary clauses into the
+    // implication lists and watches the others.
+    void attach_clauses();
 
-    std::vector<Assignment> assignment_stack;
+    // Failed literal probing followed by equivalent literal substitution at
+    // level 0. Returns false if the formula is unsatisfiable.
+    bool inprocess();
 
-    std::deque<LitId> unit_queue;
+    // Eliminates the XOR constraints again at level 0, with the variables
+    // substituted and assigned since, and propagates the units it finds.
+    // Returns false if the formula is unsatisfiable.
+    bool build_gauss();
+
+    // Assigns both polarities of candidate variables in turn. Failed
+    // literals and literals implied by both polarities become units.
+    bool probe();
+
+    bool probe_variable(VarId var);
+
+    // Replaces the literals of every strongly connected component of the
+    // binary implication graph by a single representative.
+    bool substitute_equivalences();
+
+    // Representative of each literal. Returns false if a literal and its
+    // negation are equivalent.
+    bool equivalent_literals(std::vector<LitId>& representative);
+
+    // Rewrites all clauses with representatives, drops clauses satisfied at
+    // level 0 and false literals, and rebuilds the watch and binary lists.
+    bool rebuild_clauses(const std::vector<LitId>& representative);
+
+    inline SolveResult refute() {
+        if (logging() && !formula_unsatisfiable) {
+            proof->add({});
+        }
+        formula_unsatisfiable = true;
+        return SolveResult::UNSATISFIABLE;
+    }
+
+    void split_node(std::vector<LitId>& cube, std::uint32_t depth,
+                    std::span<const VarId> candidates, std::vector<std::vector<LitId>>& cubes);
+
+    // Number of literals assigned by propagating lit one level above the
+    // current one, or nullopt if lit fails.
+    std::optional<std::size_t> lookahead(LitId lit);
+
+    // Runs ProbSAT on the irredundant clauses at level 0 and replaces the
+    // saved phases by its best assignment. Returns whether that assignment
+    // satisfies all clauses.
+    bool local_search(std::uint64_t max_flips);
+
+    // Copies the assignment into model and restores the substituted
+    // variables.
+    void store_model();
+
+    // Collects the assumptions implying the negation of the assumption lit
+    // into failed_literals.
+    void analyze_final(LitId lit);
+
+    // Adds a clause at level 0 after mapping it through the substitutions
+    // and simplifying it. Returns false on an empty clause or a conflict.
+    bool add_simplified(std::span<const LitId> literals, bool learnt, std::uint32_t lbd);
+
+    // Adds a unit clause at level 0 and propagates it.
+    bool add_unit(LitId lit);
+
+    // Compacts the clause arena and rewrites the clause references held by
+    // watchers and reasons. Watchers of deleted clauses are dropped.
+    void collect_garbage();
+
+    void sanitize() const;
+
+    SolverOptions options;
 
     VariableCache variables;
 
     ClauseCache clauses;
 
+    AssignmentStack trail;
+
+    ClauseId conflict_clause = NO_CLAUSE;
+
+    LitId conflict_literal = 0;
+
+    std::size_t binary_clause_count = 0;
+
+    std::vector<LitId> learnt_clause;
+
+    std::uint32_t learnt_lbd = 0;
+
+    std::vector<bool> seen;
+
+    std::vector<std::uint64_t> level_stamp;
+
+    std::uint64_t current_stamp = 0;
+
+    ActivityHeap heap;
+
+    RestartScheduler<Policy> restarts;
+
+    std::vector<bool> saved_phase;
+
+    std::uint64_t conflicts = 0;
+
+    std::uint64_t reduce_interval;
+
+    std::uint64_t next_reduce;
+
+    double clause_increment = 1.0;
+
+    std::vector<std::uint64_t> literal_stamp;
+
+    std::uint64_t next_inprocess = 0;
+
+    VarId probe_position = 1;
+
+    ModelReconstruction substituted;
+
+    // Representative of every literal after equivalent literal substitution.
+    std::vector<LitId> equivalent;
+
+    // The XOR constraints found when the formula was loaded, in its original
+    // variables.
+    std::vector<XorConstraint> xors;
+
+    GaussEngine gauss;
+
+    // The engine is built at the next solve(), after set_proof() had its
+    // chance to turn it off.
+    bool gauss_stale = false;
+
+    constexpr static std::uint64_t NO_LIMIT = std::numeric_limits<std::uint64_t>::max();
+
+    std::uint64_t conflict_limit = NO_LIMIT;
+
+    std::uint64_t propagations = 0;
+
+    std::uint64_t propagation_limit = NO_LIMIT;
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr static Clock::time_point NO_DEADLINE = Clock::time_point::max();
+
+    // Longer time budgets count as unlimited.
+    constexpr static double MAX_BUDGET_SECONDS = 1e9;
+
+    Clock::time_point deadline = NO_DEADLINE;
+
+    std::uint64_t memory_limit = NO_LIMIT;
+
+    constexpr static std::uint32_t BUDGET_CHECK_INTERVAL = 256;
+
+    std::uint32_t budget_countdown = BUDGET_CHECK_INTERVAL;
+
+    std::atomic<bool> interrupt_requested{false};
+
+    std::vector<LitId> best_assignment;
+
+    // Length of the prefix best_assignment has in common with the trail.
+    std::size_t best_shared = 0;
+
+    bool formula_unsatisfiable = false;
+
+    bool conflicting_units = false;
+
+    bool interrupted = false;
+
+    std::function<bool()> terminate_callback;
+
+    std::uint32_t learn_limit = 0;
+
+    std::function<void(std::span<const LitId>)> learn_callback;
+
+    std::vector<Value> model;
+
+    std::vector<LitId> failed_literals;
+
+    const std::atomic<bool>* terminate = nullptr;
+
+    ClauseExchange* exchange = nullptr;
+
+    std::uint32_t exchange_index = 0;
+
+    SearchStatistics stats;
+
+    std::uint64_t progress_interval = 1;
+
+    std::function<void(const SearchStatistics&)> progress_callback;
+
+    ProofWriter* proof = nullptr;
+
+    std::uint64_t next_local_search = 0;
+
+    std::uint64_t local_search_rounds = 0;
+
+    // Kept between rounds of local search until the irredundant clauses
+    // change, see local_search().
+    std::optional<LocalSearch> local_searcher;
+
+    bool local_search_stale = true;
+
+    // Level 0 assignment handed to local search, indexed by variable.
+    std::vector<Value> local_search_fixed;
+
 };
 
+// Configured by the options alone.
+using Solver = BasicSolver<RuntimePolicy>;
+
 }  // namespace NimmerSAT
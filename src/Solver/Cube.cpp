@@ -0,0 +1,160 @@
+
+#include "Cube.h"
+
+#include <thread>
+
+namespace NimmerSAT {
+
+CubeAndConquer::CubeAndConquer(std::uint32_t variable_count, const ClauseCache& formula,
+                               SolverOptions options, std::uint32_t thread_count, CubeOptions cube_options) :
+    variable_count(variable_count),
+    formula(formula),
+    options(options),
+    cube_options(cube_options),
+    solvers(thread_count),
+    queues(thread_count)
+{
+}
+
+SolveResult CubeAndConquer::solve() {
+    // The first worker splits the formula before the others start.
+    solvers[0] = std::make_unique<Solver>(variable_count, formula.clone(), options);
+    std::vector<Cube> cubes = solvers[0]->split({}, cube_options.depth);
+    if (cubes.empty()) {
+        return SolveResult::UNSATISFIABLE;
+    }
+    for (std::size_t i = 0; i < cubes.size(); i++) {
+        push(static_cast<std::uint32_t>(i % queues.size()), std::move(cubes[i]));
+    }
+
+    std::vector<std::thread> threads;
+    for (std::uint32_t index = 0; index < solvers.size(); index++) {
+        threads.emplace_back([this, index] {
+            work(index);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // Every cube was refuted.
+    if (!finished.load()) {
+        result = SolveResult::UNSATISFIABLE;
+    }
+    return result;
+}
+
+void CubeAndConquer::work(std::uint32_t index) {
+    if (!solvers[index]) {
+        solvers[index] = std::make_unique<Solver>(variable_count, formula.clone(), options);
+    }
+    Solver &solver = *solvers[index];
+    solver.set_terminate(&finished);
+
+    while (!finished.load(std::memory_order_relaxed)) {
+        std::optional<Cube> cube = take(index);
+        if (!cube) {
+            if (pending.load() == 0) {
+                break;
+            }
+            wait_for_work();
+            continue;
+        }
+
+        solver.set_conflict_budget(cube_options.conflict_budget);
+        SolveResult answer = solver.solve(*cube);
+        if (answer == SolveResult::SATISFIABLE || solver.inconsistent()) {
+            finish(index, answer);
+            break;
+        }
+        if (answer == SolveResult::UNKNOWN) {
+            if (finished.load(std::memory_order_relaxed)) {
+                break;
+            }
+            // An empty split means propagation refuted the cube meanwhile.
+            for (Cube &half : solver.split(*cube, 1)) {
+                push(index, std::move(half));
+            }
+            if (solver.inconsistent()) {
+                finish(index, SolveResult::UNSATISFIABLE);
+                break;
+            }
+        }
+        if (--pending == 0) {
+            notify_idle(true);
+        }
+    }
+}
+
+void CubeAndConquer::push(std::uint32_t index, Cube cube) {
+    pending++;
+    {
+        std::lock_guard lock(queues[index].mutex);
+        queues[index].cubes.push_back(std::move(cube));
+    }
+    queued++;
+    notify_idle(false);
+}
+
+std::optional<CubeAndConquer::Cube> CubeAndConquer::take(std::uint32_t index) {
+    {
+        std::lock_guard lock(queues[index].mutex);
+        if (!queues[index].cubes.empty()) {
+            Cube cube = std::move(queues[index].cubes.back());
+            queues[index].cubes.pop_back();
+            queued--;
+            return cube;
+        }
+    }
+    for (std::uint32_t offset = 1; offset < queues.size(); offset++) {
+        WorkQueue &victim = queues[(index + offset) % queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.cubes.empty()) {
+            Cube cube = std::move(victim.cubes.front());
+            victim.cubes.pop_front();
+            queued--;
+            return cube;
+        }
+    }
+    return std::nullopt;
+}
+
+void CubeAndConquer::wait_for_work() {
+    std::unique_lock lock(idle_mutex);
+    idle.wait(lock, [this] {
+        return queued.load() > 0 || pending.load() == 0 || finished.load();
+    });
+}
+
+void CubeAndConquer::notify_idle(bool all) {
+    // Taking the lock orders the change before the check of a worker about
+    // to wait, so that the wakeup is not lost.
+    {
+        std::lock_guard lock(idle_mutex);
+    }
+    if (all) {
+        idle.notify_all();
+    } else {
+        idle.notify_one();
+    }
+}
+
+void CubeAndConquer::finish(std::uint32_t index, SolveResult answer) {
+    if (!finished.exchange(true)) {
+        winner_index = index;
+        result = answer;
+    }
+    notify_idle(true);
+}
+
+SearchStatistics CubeAndConquer::statistics() const {
+    SearchStatistics total;
+    for (const auto &solver : solvers) {
+        if (solver) {
+            total += solver->statistics();
+        }
+    }
+    return total;
+}
+
+}  // namespace NimmerSAT
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "Formula/FormulaCache.h"
+#include "Assign.h"
+#include "Options.h"
+
+namespace NimmerSAT {
+
+struct CubeOptions {
+    // The formula is split into at most 2^depth cubes up front.
+    std::uint32_t depth = 12;
+
+    // Conflicts spent on a cube before it is split in two.
+    std::uint64_t conflict_budget = 10'000;
+};
+
+// Cube and conquer: lookahead splits the formula into cubes, which a pool of
+// CDCL solvers then solves under assumptions. Every worker takes cubes from
+// the back of its own queue and steals from the front of the others once it
+// runs dry. A cube exceeding its conflict budget is split again by its
+// worker. The formula is satisfiable if any cube is, and unsatisfiable once
+// all cubes are refuted.
+class CubeAndConquer final {
+public:
+
+    CubeAndConquer(std::uint32_t variable_count, const ClauseCache& formula,
+                   SolverOptions options, std::uint32_t thread_count, CubeOptions cube_options = {});
+
+    CubeAndConquer(const CubeAndConquer&) = delete;
+    CubeAndConquer& operator=(const CubeAndConquer&) = delete;
+
+    ~CubeAndConquer() = default;
+
+    SolveResult solve();
+
+    // The solver that found the answer, holding the model if there is one.
+    inline Solver& winner() {
+        return *solvers[winner_index];
+    }
+
+    // Sum of the statistics of all solvers.
+    SearchStatistics statistics() const;
+
+private:
+
+    using Cube = std::vector<LitId>;
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Cube> cubes;
+    };
+
+    void work(std::uint32_t index);
+
+    void push(std::uint32_t index, Cube cube);
+
+    // Own cubes last in first out, stolen ones first in first out, so that
+    // thieves take the cubes closest to the root.
+    std::optional<Cube> take(std::uint32_t index);
+
+    // Blocks an idle worker until a cube is queued, all cubes are done or
+    // the search is finished.
+    void wait_for_work();
+
+    // Wakes the idle workers after queued, pending or finished changed.
+    void notify_idle(bool all);
+
+    void finish(std::uint32_t index, SolveResult answer);
+
+    std::uint32_t variable_count;
+
+    const ClauseCache& formula;
+
+    SolverOptions options;
+
+    CubeOptions cube_options;
+
+    std::vector<std::unique_ptr<Solver>> solvers;
+
+    std::vector<WorkQueue> queues;
+
+    // Cubes queued or being solved.
+    std::atomic<std::uint64_t> pending{0};
+
+    // Cubes waiting in the queues.
+    std::atomic<std::uint64_t> queued{0};
+
+    std::atomic<bool> finished{false};
+
+    std::mutex idle_mutex;
+
+    std::condition_variable idle;
+
+    std::uint32_t winner_index = 0;
+
+    SolveResult result = SolveResult::UNKNOWN;
+
+};
+
+}  // namespace NimmerSAT
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "NSatUtility.h"
+
+namespace NimmerSAT {
+
+// Learnt clauses shared between the solvers of a portfolio. Every solver
+// publishes into a ring buffer of its own and reads the rings of all other
+// solvers without taking a lock. A slow reader may find that part of a ring
+// was overwritten, in which case the lost clauses are skipped.
+class ClauseExchange final {
+public:
+
+    // Longer clauses are never shared.
+    constexpr static std::uint32_t MAX_CLAUSE_SIZE = 32;
+
+    explicit ClauseExchange(std::uint32_t solver_count) :
+        rings(solver_count),
+        read_positions(solver_count, std::vector<std::uint64_t>(solver_count, 0))
+    {
+        for (auto &ring : rings) {
+            ring.words = std::make_unique<std::atomic<LitId>[]>(CAPACITY);
+        }
+    }
+
+    ClauseExchange(const ClauseExchange&) = delete;
+    ClauseExchange& operator=(const ClauseExchange&) = delete;
+
+    ~ClauseExchange() = default;
+
+    // Only called by the thread of solver producer.
+    inline void publish(std::uint32_t producer, std::span<const LitId> clause, std::uint32_t lbd) {
+        Ring &ring = rings[producer];
+        std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+        // Readers that see any of the words below also see the head they
+        // were written after.
+        std::atomic_thread_fence(std::memory_order_release);
+        ring.store(head, static_cast<LitId>(clause.size()));
+        ring.store(head + 1, lbd);
+        for (std::size_t i = 0; i < clause.size(); i++) {
+            ring.store(head + 2 + i, clause[i]);
+        }
+        ring.head.store(head + 2 + clause.size(), std::memory_order_release);
+    }
+
+    // Calls import(literals, lbd) for every clause published by the other
+    // solvers since the last call by consumer. Stops and returns false as
+    // soon as import does.
+    template <typename Import>
+    bool collect(std::uint32_t consumer, Import&& import) {
+        for (std::uint32_t producer = 0; producer < rings.size(); producer++) {
+            if (producer == consumer) {
+                continue;
+            }
+            Ring &ring = rings[producer];
+            std::uint64_t &position = read_positions[consumer][producer];
+            std::uint64_t head = ring.head.load(std::memory_order_acquire);
+            std::array<LitId, MAX_CLAUSE_SIZE> clause;
+
+            while (position < head) {
+                std::uint32_t size = ring.load(position);
+                std::uint32_t lbd = ring.load(position + 1);
+                if (size == 0 || size > MAX_CLAUSE_SIZE) {
+                    position = head;
+                    break;
+                }
+                for (std::uint32_t i = 0; i < size; i++) {
+                    clause[i] = ring.load(position + 2 + i);
+                }
+
+                // The words are valid if the writer cannot have reached them
+                // again, even with an entry it has not published yet.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                std::uint64_t current = ring.head.load(std::memory_order_relaxed);
+                if (current + MAX_ENTRY_WORDS > position + CAPACITY) {
+                    position = current;
+                    break;
+                }
+
+                position += 2 + size;
+                if (!import(std::span<const LitId>(clause.data(), size), lbd)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+
+    // Words per ring. An entry is the clause size, its LBD and the literals.
+    constexpr static std::uint64_t CAPACITY = 1 << 16;
+    constexpr static std::uint64_t MAX_ENTRY_WORDS = 2 + MAX_CLAUSE_SIZE;
+
+    struct Ring {
+        std::unique_ptr<std::atomic<LitId>[]> words;
+
+        // Total number of words written, only ever increasing.
+        alignas(64) std::atomic<std::uint64_t> head{0};
+
+        inline void store(std::uint64_t position, LitId word) {
+            words[position % CAPACITY].store(word, std::memory_order_relaxed);
+        }
+
+        inline LitId load(std::uint64_t position) const {
+            return words[position % CAPACITY].load(std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<Ring> rings;
+
+    // Per consumer, the position up to which each ring has been read.
+    std::vector<std::vector<std::uint64_t>> read_positions;
+
+};
+
+}  // namespace NimmerSAT
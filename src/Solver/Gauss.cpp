@@ -0,0 +1,441 @@
+#include "Gauss.h"
+#include "NSatUtility.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <bitset>
+#include <sstream>
+
+namespace NimmerSAT {
+
+std::vector<XorConstraint> FindXors(const ClauseCache& clauses, std::uint32_t max_size) {
+    max_size = std::min(max_size, MAX_XOR_SIZE);
+
+    // Candidate clauses with their variables sorted, hashed for grouping,
+    // and the signs of the literals in that order as a bit mask.
+    struct Candidate {
+        std::uint64_t hash;
+        std::uint32_t start;
+        std::uint32_t size;
+        std::uint32_t signs;
+    };
+    std::vector<VarId> variables;
+    std::vector<Candidate> candidates;
+    std::vector<LitId> sorted;
+    for (ClauseId clause_id : clauses) {
+        const Clause clause = clauses[clause_id];
+        if (clause.deleted() || clause.learnt() || clause.size() < 3 || clause.size() > max_size) {
+            continue;
+        }
+        sorted.assign(clause.begin(), clause.end());
+        std::sort(sorted.begin(), sorted.end());
+
+        Candidate candidate{0, static_cast<std::uint32_t>(variables.size()), clause.size(), 0};
+        bool distinct = true;
+        for (std::uint32_t i = 0; i < sorted.size(); i++) {
+            VarId var = LitToVar(sorted[i]);
+            if (i > 0 && var == LitToVar(sorted[i - 1])) {
+                distinct = false;
+                break;
+            }
+            variables.push_back(var);
+            candidate.hash = candidate.hash * 0x9E3779B97F4A7C15 + var;
+            candidate.signs |= static_cast<std::uint32_t>(!IsPositive(sorted[i])) << i;
+        }
+        if (!distinct) {
+            variables.resize(candidate.start);
+            continue;
+        }
+        candidates.push_back(candidate);
+    }
+
+    auto variables_of = [&](const Candidate& candidate) {
+        return std::span<const VarId>(variables.data() + candidate.start, candidate.size);
+    };
+    auto same_variables = [&](const Candidate& a, const Candidate& b) {
+        return a.hash == b.hash && a.size == b.size &&
+            std::ranges::equal(variables_of(a), variables_of(b));
+    };
+    std::sort(candidates.begin(), candidates.end(), [&](const Candidate& a, const Candidate& b) {
+        if (a.hash != b.hash) {
+            return a.hash < b.hash;
+        }
+        if (a.size != b.size) {
+            return a.size < b.size;
+        }
+        return std::ranges::lexicographical_compare(variables_of(a), variables_of(b));
+    });
+
+    // Each group of clauses over the same variables holds an XOR if it has
+    // every sign pattern of one parity, duplicates aside.
+    std::vector<XorConstraint> xors;
+    for (std::size_t begin = 0; begin < candidates.size();) {
+        std::size_t end = begin + 1;
+        while (end < candidates.size() && same_variables(candidates[begin], candidates[end])) {
+            end++;
+        }
+        std::size_t needed = std::size_t{1} << (candidates[begin].size - 1);
+        if (end - begin >= needed) {
+            std::bitset<std::size_t{1} << MAX_XOR_SIZE> present;
+            std::array<std::size_t, 2> count{};
+            for (std::size_t i = begin; i < end; i++) {
+                std::uint32_t signs = candidates[i].signs;
+                if (!present[signs]) {
+                    present.set(signs);
+                    count[std::popcount(signs) & 1]++;
+                }
+            }
+            // The clauses exclude the assignments with an odd number of
+            // true variables for an even number of negative literals.
+            for (std::uint32_t negative_parity : {0, 1}) {
+                if (count[negative_parity] == needed) {
+                    std::span<const VarId> vars = variables_of(candidates[begin]);
+                    xors.push_back({std::vector<VarId>(vars.begin(), vars.end()), negative_parity == 0});
+                }
+            }
+        }
+        begin = end;
+    }
+    return xors;
+}
+
+bool GaussEngine::build(std::span<const XorConstraint> constraints, const std::vector<LitId>& representative,
+                        const VariableCache& variables_cache, std::vector<LitId>& units) {
+    clear();
+
+    // Columns for the unassigned representatives, in order of appearance.
+    columns.assign(std::size_t{variables_cache.variable_count()} + 1, NO_COLUMN);
+    for (const XorConstraint &constraint : constraints) {
+        for (VarId original : constraint.variables) {
+            VarId var = LitToVar(representative[VarToLit(original, true)]);
+            if (variables_cache.var_val(var) == Value::UNASSIGNED && columns[var] == NO_COLUMN) {
+                columns[var] = column_count++;
+                variables.push_back(var);
+            }
+        }
+    }
+    words = (column_count + 63) / 64;
+    if (words == 0 || constraints.size() * words > MAX_MATRIX_WORDS) {
+        clear();
+        return true;
+    }
+
+    // Substituted variables may meet twice in a row and cancel out.
+    row_count = static_cast<std::uint32_t>(constraints.size());
+    matrix.assign(std::size_t{row_count} * words, 0);
+    parity.assign(row_count, 0);
+    for (std::uint32_t row = 0; row < row_count; row++) {
+        bool sum = constraints[row].parity;
+        for (VarId original : constraints[row].variables) {
+            LitId lit = representative[VarToLit(original, true)];
+            VarId var = LitToVar(lit);
+            sum ^= !IsPositive(lit);
+            if (Value value = variables_cache.var_val(var); value != Value::UNASSIGNED) {
+                sum ^= value == Value::TRUE;
+                continue;
+            }
+            row_bits(row)[columns[var] / 64] ^= std::uint64_t{1} << (columns[var] % 64);
+        }
+        parity[row] = sum;
+    }
+
+    // Gauss-Jordan elimination. Empty rows are dropped, unless their parity
+    // is odd, and rows of a single column are units.
+    basic.assign(row_count, NO_COLUMN);
+    for (std::uint32_t row = 0; row < row_count; row++) {
+        std::uint32_t column = first_column(row);
+        if (column == NO_COLUMN) {
+            if (parity[row]) {
+                clear();
+                return false;
+            }
+            continue;
+        }
+        basic[row] = column;
+        for (std::uint32_t other = 0; other < row_count; other++) {
+            if (other != row && contains(other, column)) {
+                add_row(other, row);
+            }
+        }
+    }
+
+    // Every column starts out unassigned.
+    unassigned.assign(words, ~std::uint64_t{0});
+    if (column_count % 64 != 0) {
+        unassigned.back() = (std::uint64_t{1} << (column_count % 64)) - 1;
+    }
+    true_values.assign(words, 0);
+
+    std::uint32_t kept = 0;
+    for (std::uint32_t row = 0; row < row_count; row++) {
+        if (basic[row] == NO_COLUMN) {
+            continue;
+        }
+        if (find_unassigned(row, basic[row]) == NO_COLUMN) {
+            units.push_back(VarToLit(variables[basic[row]], parity[row]));
+            continue;
+        }
+        std::copy_n(row_bits(row), words, row_bits(kept));
+        parity[kept] = parity[row];
+        basic[kept] = basic[row];
+        kept++;
+    }
+    row_count = kept;
+    matrix.resize(std::size_t{row_count} * words);
+    parity.resize(row_count);
+    basic.resize(row_count);
+
+    watchers.resize(column_count);
+    watched.resize(row_count);
+    for (std::uint32_t row = 0; row < row_count; row++) {
+        watched[row] = find_unassigned(row, basic[row]);
+        watchers[basic[row]].push_back(row);
+        watchers[watched[row]].push_back(row);
+    }
+    row_stamp.assign(row_count, 0);
+    if (reasons.size() < columns.size()) {
+        reasons.resize(columns.size());
+    }
+    if (row_count == 0) {
+        clear();
+    }
+    return true;
+}
+
+void GaussEngine::clear() {
+    row_count = 0;
+    column_count = 0;
+    words = 0;
+    matrix.clear();
+    parity.clear();
+    basic.clear();
+    watched.clear();
+    for (auto &rows : watchers) {
+        rows.clear();
+    }
+    row_stamp.clear();
+    columns.clear();
+    variables.clear();
+    unassigned.clear();
+    true_values.clear();
+    implications.clear();
+    conflict_literals.clear();
+}
+
+bool GaussEngine::propagate(VarId var) {
+    implications.clear();
+    std::uint32_t column = column_of(var);
+    if (column == NO_COLUMN) {
+        return true;
+    }
+
+    // Rows visited twice, and rows no longer watching the column, are
+    // dropped from its list. Rows eliminating the column may append
+    // themselves while it is visited.
+    current_stamp++;
+    bool consistent = true;
+    std::size_t read = 0;
+    std::size_t write = 0;
+    std::size_t count = watchers[column].size();
+    while (read < count) {
+        std::uint32_t row = watchers[column][read++];
+        if (row_stamp[row] == current_stamp || (basic[row] != column && watched[row] != column)) {
+            continue;
+        }
+        row_stamp[row] = current_stamp;
+
+        bool keep = basic[row] == column ?
+            update_basic(row, column, consistent) :
+            update_watched(row, consistent);
+        if (keep) {
+            watchers[column][write++] = row;
+        }
+        if (!consistent) {
+            while (read < count) {
+                watchers[column][write++] = watchers[column][read++];
+            }
+        }
+    }
+    auto &rows = watchers[column];
+    for (std::size_t appended = count; appended < rows.size(); appended++) {
+        rows[write++] = rows[appended];
+    }
+    rows.resize(write);
+    return consistent;
+}
+
+bool GaussEngine::update_basic(std::uint32_t row, std::uint32_t column, bool& consistent) {
+    if (std::uint32_t next = find_unassigned(row, watched[row]); next != NO_COLUMN) {
+        pivot(row, next, column, consistent);
+        return false;
+    }
+    settle(row, watched[row], consistent);
+    return true;
+}
+
+bool GaussEngine::update_watched(std::uint32_t row, bool& consistent) {
+    // The assigned column itself is never found.
+    if (std::uint32_t next = find_unassigned(row, basic[row]); next != NO_COLUMN) {
+        watched[row] = next;
+        watchers[next].push_back(row);
+        return false;
+    }
+    settle(row, basic[row], consistent);
+    return true;
+}
+
+void GaussEngine::pivot(std::uint32_t row, std::uint32_t column, std::uint32_t old_basic, bool& consistent) {
+    basic[row] = column;
+    watchers[column].push_back(row);
+
+    for (std::uint32_t other = 0; other < row_count; other++) {
+        if (other == row || !contains(other, column)) {
+            continue;
+        }
+        add_row(other, row);
+        if (contains(other, watched[other])) {
+            continue;
+        }
+        if (std::uint32_t next = find_unassigned(other, basic[other]); next != NO_COLUMN) {
+            watched[other] = next;
+            watchers[next].push_back(other);
+            continue;
+        }
+
+        // The row now contains the old basic column, which no other row
+        // did, so it can always fall back to watching that one.
+        watched[other] = old_basic;
+        watchers[old_basic].push_back(other);
+        settle(other, basic[other], consistent);
+    }
+}
+
+void GaussEngine::settle(std::uint32_t row, std::uint32_t target, bool& consistent) {
+    if (is_unassigned(target)) {
+        imply(row, target);
+        return;
+    }
+    if (consistent && !satisfied(row)) {
+        consistent = false;
+        conflict_literals.clear();
+        const std::uint64_t* bits = row_bits(row);
+        for (std::uint32_t word = 0; word < words; word++) {
+            for (std::uint64_t rest = bits[word]; rest != 0; rest &= rest - 1) {
+                conflict_literals.push_back(false_literal(word * 64 + static_cast<std::uint32_t>(std::countr_zero(rest))));
+            }
+        }
+    }
+}
+
+void GaussEngine::imply(std::uint32_t row, std::uint32_t column) {
+    auto &reason = reasons[variables[column]];
+    reason.clear();
+    reason.push_back(0);
+    bool value = parity[row];
+    const std::uint64_t* bits = row_bits(row);
+    for (std::uint32_t word = 0; word < words; word++) {
+        for (std::uint64_t rest = bits[word]; rest != 0; rest &= rest - 1) {
+            std::uint32_t other = word * 64 + static_cast<std::uint32_t>(std::countr_zero(rest));
+            if (other != column) {
+                value ^= is_true(other);
+                reason.push_back(false_literal(other));
+            }
+        }
+    }
+    LitId lit = VarToLit(variables[column], value);
+    reason[0] = lit;
+    set(lit);
+    implications.push_back(lit);
+}
+
+void GaussEngine::adopt_conflict(LitId lit) {
+    auto &reason = reasons[LitToVar(lit)];
+    reason.assign(conflict_literals.begin(), conflict_literals.end());
+    std::swap(reason[0], *std::find(reason.begin(), reason.end(), lit));
+}
+
+std::uint32_t GaussEngine::find_unassigned(std::uint32_t row, std::uint32_t skip) const {
+    const std::uint64_t* bits = row_bits(row);
+    for (std::uint32_t word = 0; word < words; word++) {
+        std::uint64_t candidates = bits[word] & unassigned[word];
+        if (skip / 64 == word) {
+            candidates &= ~(std::uint64_t{1} << (skip % 64));
+        }
+        if (candidates != 0) {
+            return word * 64 + static_cast<std::uint32_t>(std::countr_zero(candidates));
+        }
+    }
+    return NO_COLUMN;
+}
+
+std::uint32_t GaussEngine::first_column(std::uint32_t row) const {
+    const std::uint64_t* bits = row_bits(row);
+    for (std::uint32_t word = 0; word < words; word++) {
+        if (bits[word] != 0) {
+            return word * 64 + static_cast<std::uint32_t>(std::countr_zero(bits[word]));
+        }
+    }
+    return NO_COLUMN;
+}
+
+// The loops over whole rows are kept free of branches so that they compile
+// to vector instructions where the target has them.
+void GaussEngine::add_row(std::uint32_t target, std::uint32_t source) {
+    std::uint64_t* to = row_bits(target);
+    const std::uint64_t* from = row_bits(source);
+    for (std::uint32_t word = 0; word < words; word++) {
+        to[word] ^= from[word];
+    }
+    parity[target] ^= parity[source];
+}
+
+bool GaussEngine::satisfied(std::uint32_t row) const {
+    const std::uint64_t* bits = row_bits(row);
+    int sum = parity[row];
+    for (std::uint32_t word = 0; word < words; word++) {
+        sum += std::popcount(bits[word] & true_values[word]);
+    }
+    return (sum & 1) == 0;
+}
+
+std::uint64_t GaussEngine::memory_usage() const {
+    std::uint64_t bytes = (matrix.size() + unassigned.size() + true_values.size()) * sizeof(std::uint64_t) +
+        std::uint64_t{row_count} * (sizeof(std::uint8_t) + 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t)) +
+        columns.size() * sizeof(std::uint32_t) + variables.size() * sizeof(VarId);
+    for (const auto &rows : watchers) {
+        bytes += rows.capacity() * sizeof(std::uint32_t);
+    }
+    for (const auto &reason : reasons) {
+        bytes += reason.capacity() * sizeof(LitId);
+    }
+    return bytes;
+}
+
+void GaussEngine::sanitize(const VariableCache& variables_cache) const {
+    for (std::uint32_t column = 0; column < column_count; column++) {
+        Value value = variables_cache.var_val(variables[column]);
+        if (is_unassigned(column) != (value == Value::UNASSIGNED) ||
+            (value != Value::UNASSIGNED && is_true(column) != (value == Value::TRUE))) {
+            std::stringstream str;
+            str << "Gauss column of variable " << variables[column] << " does not match its value";
+            Error(str);
+        }
+    }
+    for (std::uint32_t row = 0; row < row_count; row++) {
+        if (!contains(row, basic[row]) || !contains(row, watched[row]) || basic[row] == watched[row]) {
+            std::stringstream str;
+            str << "Gauss row " << row << " does not contain its watches";
+            Error(str);
+        }
+        for (std::uint32_t other = 0; other < row_count; other++) {
+            if (other != row && contains(other, basic[row])) {
+                std::stringstream str;
+                str << "Basic column of Gauss row " << row << " also in row " << other;
+                Error(str);
+            }
+        }
+    }
+}
+
+}  // namespace NimmerSAT
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "Formula/FormulaCache.h"
+#include "Formula/VariableCache.h"
+#include "NSatUtility.h"
+
+namespace NimmerSAT {
+
+// Variables summing to parity modulo 2.
+struct XorConstraint {
+    std::vector<VarId> variables;
+    bool parity = false;
+};
+
+// Longest XOR constraint FindXors looks for, encoded by 128 clauses.
+constexpr std::uint32_t MAX_XOR_SIZE = 8;
+
+// Collects the XOR constraints of 3 up to max_size variables that the
+// irredundant clauses encode directly: all 2^(k-1) clauses over the same k
+// variables whose numbers of negative literals have the same parity. Binary
+// XORs are equivalences, which are left to equivalent literal substitution.
+std::vector<XorConstraint> FindXors(const ClauseCache& clauses, std::uint32_t max_size);
+
+// Gauss-Jordan elimination over XOR constraints during the search, in the
+// simplex like scheme of Han and Jiang. The constraints are the rows of a
+// matrix over GF(2) in reduced row echelon form, each row packed into 64 bit
+// words. Every row has a basic column no other row contains and watches it
+// together with one more column. When the other watched variable is
+// assigned, another unassigned one is watched. When the basic variable is
+// assigned, an unassigned one becomes basic instead and is eliminated from
+// all other rows. A row left with a single unassigned variable implies it,
+// a row without one conflicts if its parity is wrong.
+//
+// Row operations keep the solutions of the system, so backtracking only
+// restores the assignment and never the matrix. The clauses the constraints
+// were found in stay in the formula; the engine adds the implications of
+// combined constraints, which clause propagation misses.
+class GaussEngine final {
+public:
+
+    GaussEngine() = default;
+
+    GaussEngine(const GaussEngine&) = delete;
+    GaussEngine(GaussEngine&&) = default;
+    GaussEngine& operator=(const GaussEngine&) = delete;
+    GaussEngine& operator=(GaussEngine&&) = default;
+    ~GaussEngine() = default;
+
+    // Eliminates the constraints with their variables mapped to their
+    // representative literals, and those assigned in variables replaced by
+    // their values. Variables the constraints fix on their own are appended
+    // to units instead of being kept in a row. Returns false if the
+    // constraints are inconsistent. Systems of more than MAX_MATRIX_WORDS
+    // are left out, the engine stays empty then.
+    bool build(std::span<const XorConstraint> constraints, const std::vector<LitId>& representative,
+               const VariableCache& variables, std::vector<LitId>& units);
+
+    // Drops all rows.
+    void clear();
+
+    inline bool empty() const {
+        return row_count == 0;
+    }
+
+    inline std::uint32_t size() const {
+        return row_count;
+    }
+
+    // Mirror every assignment and unassignment of the solver.
+    inline void set(LitId lit) {
+        if (std::uint32_t column = column_of(LitToVar(lit)); column != NO_COLUMN) {
+            std::uint64_t bit = std::uint64_t{1} << (column % 64);
+            unassigned[column / 64] &= ~bit;
+            if (IsPositive(lit)) {
+                true_values[column / 64] |= bit;
+            } else {
+                true_values[column / 64] &= ~bit;
+            }
+        }
+    }
+
+    inline void unset(VarId var) {
+        if (std::uint32_t column = column_of(var); column != NO_COLUMN) {
+            std::uint64_t bit = std::uint64_t{1} << (column % 64);
+            unassigned[column / 64] |= bit;
+            true_values[column / 64] &= ~bit;
+        }
+    }
+
+    // Visits the rows watching var, whose assignment was taken from the
+    // trail. The literals implied on the way count as assigned already and
+    // must be assigned by the caller in the order of implied(). Returns
+    // false on a conflict, see conflict().
+    bool propagate(VarId var);
+
+    inline std::span<const LitId> implied() const {
+        return implications;
+    }
+
+    // Reason of a literal the engine implied, starting with the literal.
+    inline std::span<const LitId> reason(VarId var) const {
+        return reasons[var];
+    }
+
+    // The literals of the row the last propagate() failed on, all false.
+    inline std::span<const LitId> conflict() const {
+        return conflict_literals;
+    }
+
+    // Turns the last conflict into the reason of its literal lit, after
+    // backtracking made it unit.
+    void adopt_conflict(LitId lit);
+
+    std::uint64_t memory_usage() const;
+
+    // Checks the mirrored assignment against variables and the echelon form.
+    void sanitize(const VariableCache& variables) const;
+
+private:
+
+    constexpr static std::uint32_t NO_COLUMN = std::numeric_limits<std::uint32_t>::max();
+
+    // Beyond 32 MiB of rows the row operations cost more than they save.
+    constexpr static std::size_t MAX_MATRIX_WORDS = std::size_t{1} << 22;
+
+    inline std::uint32_t column_of(VarId var) const {
+        return var < columns.size() ? columns[var] : NO_COLUMN;
+    }
+
+    inline std::uint64_t* row_bits(std::uint32_t row) {
+        return matrix.data() + std::size_t{row} * words;
+    }
+
+    inline const std::uint64_t* row_bits(std::uint32_t row) const {
+        return matrix.data() + std::size_t{row} * words;
+    }
+
+    inline bool contains(std::uint32_t row, std::uint32_t column) const {
+        return (row_bits(row)[column / 64] >> (column % 64)) & 1;
+    }
+
+    inline bool is_unassigned(std::uint32_t column) const {
+        return (unassigned[column / 64] >> (column % 64)) & 1;
+    }
+
+    inline bool is_true(std::uint32_t column) const {
+        return (true_values[column / 64] >> (column % 64)) & 1;
+    }
+
+    // The false literal of an assigned column.
+    inline LitId false_literal(std::uint32_t column) const {
+        return VarToLit(variables[column], !is_true(column));
+    }
+
+    // Lowest unassigned column of row other than skip, or NO_COLUMN.
+    std::uint32_t find_unassigned(std::uint32_t row, std::uint32_t skip) const;
+
+    // Lowest column of row, or NO_COLUMN if it is empty.
+    std::uint32_t first_column(std::uint32_t row) const;
+
+    // Adds the row source to the row target.
+    void add_row(std::uint32_t target, std::uint32_t source);
+
+    // Whether the assigned columns of row sum to its parity.
+    bool satisfied(std::uint32_t row) const;
+
+    // The basic variable of row was assigned.
+    bool update_basic(std::uint32_t row, std::uint32_t column, bool& consistent);
+
+    // The watched non-basic variable of row was assigned.
+    bool update_watched(std::uint32_t row, bool& consistent);
+
+    // Makes column basic in row and eliminates it from the other rows. The
+    // rows that lose their watch while the old basic column is propagated
+    // watch that one if nothing unassigned is left.
+    void pivot(std::uint32_t row, std::uint32_t column, std::uint32_t old_basic, bool& consistent);
+
+    // Implies target if it is the last unassigned column of row, or checks
+    // the parity if there is none.
+    void settle(std::uint32_t row, std::uint32_t target, bool& consistent);
+
+    void imply(std::uint32_t row, std::uint32_t column);
+
+    std::uint32_t row_count = 0;
+
+    std::uint32_t column_count = 0;
+
+    // 64 bit words per row.
+    std::uint32_t words = 0;
+
+    std::vector<std::uint64_t> matrix;
+
+    std::vector<std::uint8_t> parity;
+
+    std::vector<std::uint32_t> basic;
+
+    std::vector<std::uint32_t> watched;
+
+    // Rows watching each column. Rows that moved on are dropped lazily.
+    std::vector<std::vector<std::uint32_t>> watchers;
+
+    std::vector<std::uint64_t> row_stamp;
+
+    std::uint64_t current_stamp = 0;
+
+    // Column of every variable and variable of every column.
+    std::vector<std::uint32_t> columns;
+
+    std::vector<VarId> variables;
+
+    // Assignment of the columns as bit rows.
+    std::vector<std::uint64_t> unassigned;
+
+    std::vector<std::uint64_t> true_values;
+
+    std::vector<LitId> implications;
+
+    // Reasons indexed by variable, kept across rebuilds for the literals
+    // implied before.
+    std::vector<std::vector<LitId>> reasons;
+
+    std::vector<LitId> conflict_literals;
+
+};
+
+}  // namespace NimmerSAT
@@ -0,0 +1,331 @@
+
+#include "Assign.h"
+#include "NSatUtility.h"
+
+#include <algorithm>
+
+namespace NimmerSAT {
+
+template <typename Policy>
+bool BasicSolver<Policy>::backtrack_to_conflict() {
+    std::array<LitId, 2> binary;
+    std::span<const LitId> literals = reason_clause(conflict_clause, conflict_literal, binary);
+    std::uint32_t level = 0;
+    std::uint32_t count = 0;
+    std::uint32_t below = 0;
+    LitId highest = 0;
+    for (LitId lit : literals) {
+        std::uint32_t lit_level = variables.var_level(LitToVar(lit));
+        if (lit_level > level) {
+            below = level;
+            level = lit_level;
+            count = 1;
+            highest = lit;
+        } else if (lit_level == level) {
+            count++;
+        } else {
+            below = std::max(below, lit_level);
+        }
+    }
+    if (count > 1) {
+        backjump(level);
+        return true;
+    }
+
+    // The clause is unit at the level below, its reason literal must come
+    // first. Of the two watches, the one whose propagation found the
+    // conflict is kept, it is queued again by the backtrack.
+    backjump(level - 1);
+    if (IsBinaryReason(conflict_clause)) {
+        LitId other = literals[0] == highest ? literals[1] : literals[0];
+        assign(highest, BinaryReason(other), below);
+        return false;
+    }
+    if (conflict_clause == XOR_CONFLICT) {
+        gauss.adopt_conflict(highest);
+        assign(highest, XOR_REASON, below);
+        return false;
+    }
+    Clause clause = clauses[conflict_clause];
+    if (clause[1] == highest) {
+        std::swap(clause[0], clause[1]);
+    } else if (clause[0] != highest) {
+        auto &watchers = variables.watches(clause[0]);
+        watchers.erase(std::find_if(watchers.begin(), watchers.end(), [this](const Watcher& watcher) {
+            return watcher.clause == conflict_clause;
+        }));
+        std::swap(clause[0], *std::find(clause.begin(), clause.end(), highest));
+        variables.watch(clause[0], Watcher{conflict_clause, clause[1]});
+    }
+    assign(highest, conflict_clause, below);
+    return false;
+}
+
+template <typename Policy>
+std::uint32_t BasicSolver<Policy>::analyze() {
+    learnt_clause.clear();
+    learnt_clause.push_back(0);
+
+    std::uint32_t pending = 0;
+    std::size_t index = trail.size();
+    ClauseId reason = conflict_clause;
+    LitId implied = conflict_literal;
+    LitId uip = 0;
+    std::array<LitId, 2> binary;
+
+    // Resolve the conflict clause with the reasons of the current level in
+    // reverse trail order until a single literal of that level is left.
+    do {
+        bump_clause(reason);
+        for (LitId lit : reason_clause(reason, implied, binary)) {
+            VarId var = LitToVar(lit);
+            if (lit == uip || seen[var - 1] || variables.var_level(var) == 0) {
+                continue;
+            }
+            seen[var - 1] = true;
+            if (decision_heuristic() == DecisionHeuristic::VSIDS) {
+                heap.bump(var);
+            }
+            if (variables.var_level(var) == trail.level()) {
+                pending++;
+            } else {
+                learnt_clause.push_back(lit);
+            }
+        }
+
+        // Literals of lower levels assigned out of order may come later on
+        // the trail, they are part of the learnt clause.
+        do {
+            index--;
+        } while (!seen[LitToVar(trail[index]) - 1] || variables.var_level(LitToVar(trail[index])) != trail.level());
+
+        uip = trail[index];
+        implied = uip;
+        seen[LitToVar(uip) - 1] = false;
+        reason = variables.var_reason(LitToVar(uip));
+        pending--;
+    } while (pending > 0);
+    learnt_clause[0] = Neg(uip);
+
+    // Redundant literals are moved behind the kept ones so their seen flags
+    // can still be cleared.
+    std::size_t write = 1;
+    for (std::size_t read = 1; read < learnt_clause.size(); read++) {
+        if (!redundant(learnt_clause[read])) {
+            std::swap(learnt_clause[write++], learnt_clause[read]);
+        }
+    }
+    for (std::size_t i = 1; i < learnt_clause.size(); i++) {
+        seen[LitToVar(learnt_clause[i]) - 1] = false;
+    }
+    learnt_clause.resize(write);
+
+    learnt_lbd = compute_lbd(learnt_clause);
+
+    // The literal with the highest level after the asserting one becomes
+    // the second watch and determines the backjump level.
+    std::uint32_t backjump_level = 0;
+    for (std::size_t i = 1; i < learnt_clause.size(); i++) {
+        std::uint32_t level = variables.var_level(LitToVar(learnt_clause[i]));
+        if (level > backjump_level) {
+            backjump_level = level;
+            std::swap(learnt_clause[1], learnt_clause[i]);
+        }
+    }
+    return backjump_level;
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::redundant(LitId lit) const {
+    ClauseId reason = variables.var_reason(LitToVar(lit));
+    if (reason == NO_CLAUSE) {
+        return false;
+    }
+    std::array<LitId, 2> binary;
+    for (LitId other : reason_clause(reason, Neg(lit), binary)) {
+        VarId var = LitToVar(other);
+        if (other != Neg(lit) && !seen[var - 1] && variables.var_level(var) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Policy>
+std::uint32_t BasicSolver<Policy>::compute_lbd(std::span<const LitId> literals) {
+    current_stamp++;
+    std::uint32_t lbd = 0;
+    for (LitId lit : literals) {
+        std::uint32_t level = variables.var_level(LitToVar(lit));
+        if (level_stamp[level] != current_stamp) {
+            level_stamp[level] = current_stamp;
+            lbd++;
+        }
+    }
+    return lbd;
+}
+
+template <typename Policy>
+void BasicSolver<Policy>::learn(std::uint32_t level) {
+    if constexpr (Stats()) {
+        stats.learnt_clauses++;
+    }
+    if (logging()) {
+        proof->add(learnt_clause);
+    }
+    if (learn_callback && learnt_clause.size() <= learn_limit) {
+        learn_callback(learnt_clause);
+    }
+    if (exchange != nullptr && learnt_clause.size() <= ClauseExchange::MAX_CLAUSE_SIZE &&
+        (learnt_clause.size() <= 2 || learnt_lbd <= options.share_lbd)) {
+        exchange->publish(exchange_index, learnt_clause, learnt_lbd);
+    }
+
+    if (learnt_clause.size() == 2) {
+        variables.add_binary(learnt_clause[0], learnt_clause[1]);
+        binary_clause_count++;
+        assign(learnt_clause[0], BinaryReason(learnt_clause[1]), level);
+        return;
+    }
+
+    ClauseId clause_id = clauses.add(learnt_clause, true, learnt_lbd);
+    bump_clause(clause_id);
+    if (learnt_clause.size() > 1) {
+        variables.watch(learnt_clause[0], Watcher{clause_id, learnt_clause[1]});
+        variables.watch(learnt_clause[1], Watcher{clause_id, learnt_clause[0]});
+    }
+    assign(learnt_clause[0], clause_id, level);
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::import_shared() {
+    return exchange->collect(exchange_index, [this](std::span<const LitId> clause, std::uint32_t lbd) {
+        return add_simplified(clause, true, lbd);
+    });
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::add_simplified(std::span<const LitId> clause, bool learnt, std::uint32_t lbd) {
+    // Literals substituted by this solver are mapped to their
+    // representatives, which may make the clause a tautology.
+    current_stamp++;
+    std::vector<LitId> literals;
+    for (LitId original : clause) {
+        LitId lit = equivalent[original];
+        Value value = variables.lit_val(lit);
+        if (value == Value::TRUE || literal_stamp[Neg(lit)] == current_stamp) {
+            return true;
+        }
+        if (value == Value::UNASSIGNED && literal_stamp[lit] != current_stamp) {
+            literal_stamp[lit] = current_stamp;
+            literals.push_back(lit);
+        }
+    }
+
+    if (literals.empty()) {
+        return false;
+    }
+    if (literals.size() == 1) {
+        return add_unit(literals[0]);
+    }
+    if (!learnt) {
+        local_search_stale = true;
+    }
+    if (literals.size() == 2) {
+        variables.add_binary(literals[0], literals[1]);
+        binary_clause_count++;
+        return true;
+    }
+    ClauseId clause_id = clauses.add(literals, learnt, std::min<std::uint32_t>(lbd, static_cast<std::uint32_t>(literals.size())));
+    if (learnt) {
+        clauses[clause_id].set_used(1);
+    }
+    variables.watch(literals[0], Watcher{clause_id, literals[1]});
+    variables.watch(literals[1], Watcher{clause_id, literals[0]});
+    return true;
+}
+
+template <typename Policy>
+void BasicSolver<Policy>::bump_clause(ClauseId clause_id) {
+    if (IsBinaryReason(clause_id) || IsXorReason(clause_id)) {
+        return;
+    }
+    Clause clause = clauses[clause_id];
+    if (!clause.learnt()) {
+        return;
+    }
+
+    clause.set_activity(clause.activity() + static_cast<float>(clause_increment));
+    if (clause.activity() > 1e20f) {
+        for (ClauseId other : clauses) {
+            if (clauses[other].learnt()) {
+                clauses[other].set_activity(clauses[other].activity() * 1e-20f);
+            }
+        }
+        clause_increment *= 1e-20;
+    }
+
+    // All literals of a clause used in analysis are assigned, so its LBD
+    // can only have improved since it was learnt.
+    if (clause.lbd() > options.core_lbd) {
+        if (std::uint32_t lbd = compute_lbd(clause.literals()); lbd < clause.lbd()) {
+            clause.set_lbd(lbd);
+        }
+    }
+    clause.set_used(clause.lbd() <= options.tier2_lbd ? 2 : 1);
+}
+
+template <typename Policy>
+void BasicSolver<Policy>::reduce_db() {
+    std::vector<ClauseId> candidates;
+    for (ClauseId clause_id : clauses) {
+        Clause clause = clauses[clause_id];
+        if (!clause.learnt() || clause.deleted() || clause.lbd() <= options.core_lbd) {
+            continue;
+        }
+        if (clause.used() > 0) {
+            clause.set_used(clause.used() - 1);
+            continue;
+        }
+        if (!locked(clause_id)) {
+            candidates.push_back(clause_id);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [this](ClauseId a, ClauseId b) {
+        if (clauses[a].lbd() != clauses[b].lbd()) {
+            return clauses[a].lbd() > clauses[b].lbd();
+        }
+        return clauses[a].activity() < clauses[b].activity();
+    });
+
+    for (std::size_t i = 0; i < candidates.size() / 2; i++) {
+        if (logging()) {
+            proof->remove(clauses[candidates[i]].literals());
+        }
+        clauses.remove(candidates[i]);
+    }
+    if constexpr (Stats()) {
+        stats.reductions++;
+        stats.deleted_clauses += candidates.size() / 2;
+    }
+    collect_garbage();
+}
+
+
+#define INSTANTIATE(Policy) \
+    template bool BasicSolver<Policy>::backtrack_to_conflict(); \
+    template std::uint32_t BasicSolver<Policy>::analyze(); \
+    template bool BasicSolver<Policy>::redundant(LitId lit) const; \
+    template std::uint32_t BasicSolver<Policy>::compute_lbd(std::span<const LitId> literals); \
+    template void BasicSolver<Policy>::learn(std::uint32_t level); \
+    template bool BasicSolver<Policy>::import_shared(); \
+    template bool BasicSolver<Policy>::add_simplified(std::span<const LitId> clause, bool learnt, std::uint32_t lbd); \
+    template void BasicSolver<Policy>::bump_clause(ClauseId clause_id); \
+    template void BasicSolver<Policy>::reduce_db();
+
+NIMMERSAT_FOR_EACH_POLICY(INSTANTIATE)
+
+#undef INSTANTIATE
+
+}  // namespace NimmerSAT
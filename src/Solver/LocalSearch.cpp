@@ -0,0 +1,287 @@
+
+#include "LocalSearch.h"
+#include "Assign.h"
+#include "NSatUtility.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace NimmerSAT {
+
+LocalSearch::LocalSearch(std::uint32_t variable_count, std::uint64_t seed) :
+    variable_count(variable_count),
+    random(seed),
+    literal_stamp(2 * (std::size_t{variable_count} + 1), 0),
+    values(variable_count + 1, 0),
+    is_fixed(variable_count + 1, 0),
+    break_count(variable_count + 1, 0),
+    best(variable_count, false)
+{
+}
+
+bool LocalSearch::add_clause(std::span<const LitId> clause) {
+    current_stamp++;
+    std::size_t start = literals.size();
+    for (LitId lit : clause) {
+        if (literal_stamp[Neg(lit)] == current_stamp) {
+            literals.resize(start);
+            return true;
+        }
+        if (literal_stamp[lit] != current_stamp) {
+            literal_stamp[lit] = current_stamp;
+            literals.push_back(lit);
+        }
+    }
+    if (literals.size() == start) {
+        return false;
+    }
+    max_clause_size = std::max(max_clause_size, static_cast<std::uint32_t>(literals.size() - start));
+    starts.push_back(static_cast<std::uint32_t>(literals.size()));
+    return true;
+}
+
+void LocalSearch::prepare() {
+    std::size_t clause_count = starts.size() - 1;
+    if (true_count.size() == clause_count && !occurrence_starts.empty()) {
+        return;
+    }
+
+    std::size_t literal_count = 2 * (std::size_t{variable_count} + 1);
+    occurrence_starts.assign(literal_count + 1, 0);
+    for (LitId lit : literals) {
+        occurrence_starts[lit + 1]++;
+    }
+    for (std::size_t lit = 0; lit < literal_count; lit++) {
+        occurrence_starts[lit + 1] += occurrence_starts[lit];
+    }
+    occurrences.resize(literals.size());
+    std::vector<std::uint32_t> fill(occurrence_starts.begin(), occurrence_starts.end() - 1);
+    for (std::uint32_t clause = 0; clause < clause_count; clause++) {
+        for (std::uint32_t i = starts[clause]; i < starts[clause + 1]; i++) {
+            occurrences[fill[literals[i]]++] = clause;
+        }
+    }
+
+    true_count.resize(clause_count);
+    critical.resize(clause_count);
+    unsatisfied_position.resize(clause_count);
+
+    // The values ProbSAT was tuned with for clauses of up to 3, 4, 5, 6 and
+    // 7 literals.
+    constexpr double EPS = 0.9;
+    double cb = max_clause_size <= 3 ? 2.06 :
+        max_clause_size == 4 ? 3.0 :
+        max_clause_size == 5 ? 3.7 :
+        max_clause_size == 6 ? 5.1 : 5.4;
+    for (std::size_t breaks = 0; breaks <= MAX_BREAK; breaks++) {
+        weights[breaks] = std::pow(EPS + static_cast<double>(breaks), -cb);
+    }
+}
+
+void LocalSearch::initialize(const std::vector<bool>& phases, const std::vector<Value>& fixed) {
+    for (VarId var = 1; var <= variable_count; var++) {
+        is_fixed[var] = fixed[var] != Value::UNASSIGNED;
+        values[var] = is_fixed[var] ? fixed[var] == Value::TRUE : phases[var - 1];
+    }
+    std::fill(break_count.begin(), break_count.end(), 0);
+    unsatisfied.clear();
+
+    for (std::uint32_t clause = 0; clause < true_count.size(); clause++) {
+        std::uint32_t count = 0;
+        VarId xored = 0;
+        for (std::uint32_t i = starts[clause]; i < starts[clause + 1]; i++) {
+            if (is_true(literals[i])) {
+                count++;
+                xored ^= LitToVar(literals[i]);
+            }
+        }
+        true_count[clause] = count;
+        critical[clause] = xored;
+        if (count == 0) {
+            make_unsatisfied(clause);
+        } else if (count == 1) {
+            break_count[xored]++;
+        }
+    }
+}
+
+void LocalSearch::flip(VarId var) {
+    values[var] ^= 1;
+    LitId now_true = VarToLit(var, values[var] != 0);
+
+    for (std::uint32_t i = occurrence_starts[now_true]; i < occurrence_starts[now_true + 1]; i++) {
+        std::uint32_t clause = occurrences[i];
+        if (true_count[clause]++ == 0) {
+            make_satisfied(clause);
+            break_count[var]++;
+        } else if (true_count[clause] == 2) {
+            break_count[critical[clause]]--;
+        }
+        critical[clause] ^= var;
+    }
+
+    LitId now_false = Neg(now_true);
+    for (std::uint32_t i = occurrence_starts[now_false]; i < occurrence_starts[now_false + 1]; i++) {
+        std::uint32_t clause = occurrences[i];
+        critical[clause] ^= var;
+        if (--true_count[clause] == 0) {
+            make_unsatisfied(clause);
+            break_count[var]--;
+        } else if (true_count[clause] == 1) {
+            break_count[critical[clause]]++;
+        }
+    }
+}
+
+VarId LocalSearch::pick(std::uint32_t clause) {
+    std::uint32_t start = starts[clause];
+    std::uint32_t size = starts[clause + 1] - start;
+    candidate_weights.resize(size);
+    double sum = 0.0;
+    VarId last = 0;
+    for (std::uint32_t i = 0; i < size; i++) {
+        VarId var = LitToVar(literals[start + i]);
+        if (is_fixed[var]) {
+            candidate_weights[i] = 0.0;
+            continue;
+        }
+        std::uint32_t breaks = std::min<std::uint32_t>(break_count[var], MAX_BREAK);
+        candidate_weights[i] = weights[breaks];
+        sum += weights[breaks];
+        last = var;
+    }
+    if (last == 0) {
+        return 0;
+    }
+
+    double threshold = std::uniform_real_distribution<double>(0.0, sum)(random);
+    for (std::uint32_t i = 0; i + 1 < size; i++) {
+        threshold -= candidate_weights[i];
+        if (threshold < 0.0 && candidate_weights[i] > 0.0) {
+            return LitToVar(literals[start + i]);
+        }
+    }
+    return last;
+}
+
+bool LocalSearch::run(const std::vector<bool>& phases, const std::vector<Value>& fixed, std::uint64_t max_flips) {
+    prepare();
+    initialize(phases, fixed);
+    flips = 0;
+    best_unsatisfied_count = unsatisfied.size();
+    trail.clear();
+    best_in_trail = true;
+
+    while (!unsatisfied.empty() && flips < max_flips) {
+        std::uniform_int_distribution<std::size_t> choice(0, unsatisfied.size() - 1);
+        VarId var = pick(unsatisfied[choice(random)]);
+        if (var == 0) {
+            // The fixed variables falsify the clause.
+            break;
+        }
+        flip(var);
+        flips++;
+
+        if (unsatisfied.size() < best_unsatisfied_count) {
+            best_unsatisfied_count = unsatisfied.size();
+            trail.clear();
+            best_in_trail = true;
+        } else if (best_in_trail) {
+            trail.push_back(var);
+            if (trail.size() > variable_count + std::size_t{1024}) {
+                save_best();
+            }
+        }
+    }
+
+    if (best_in_trail) {
+        save_best();
+    }
+    return best_unsatisfied_count == 0;
+}
+
+void LocalSearch::save_best() {
+    for (VarId var = 1; var <= variable_count; var++) {
+        best[var - 1] = values[var] != 0;
+    }
+    for (VarId var : trail) {
+        best[var - 1] = !best[var - 1];
+    }
+    trail.clear();
+    best_in_trail = false;
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::local_search(std::uint64_t max_flips) {
+    // The irredundant clauses, with binary clauses taken from the
+    // implication lists once each, are copied only after they changed. The
+    // level 0 assignment is passed to every run instead of being simplified
+    // into the copy.
+    if (!local_searcher || local_search_stale) {
+        LocalSearch &search = local_searcher.emplace(variables.variable_count(),
+                                                     options.seed + local_search_rounds++);
+        for (ClauseId clause_id : clauses) {
+            Clause clause = clauses[clause_id];
+            if (!clause.deleted() && !clause.learnt()) {
+                search.add_clause(clause.literals());
+            }
+        }
+        for (LitId lit = 2; lit < 2 * (std::size_t{variables.variable_count()} + 1); lit++) {
+            for (LitId implied : variables.binaries(lit)) {
+                if (Neg(lit) <= implied) {
+                    std::array<LitId, 2> binary{Neg(lit), implied};
+                    search.add_clause(binary);
+                }
+            }
+        }
+        local_search_stale = false;
+    }
+
+    // Called at level 0, so every assigned variable is fixed.
+    local_search_fixed.resize(variables.variable_count() + 1);
+    for (VarId var = 1; var <= variables.variable_count(); var++) {
+        local_search_fixed[var] = variables.var_val(var);
+    }
+    bool found = local_searcher->run(saved_phase, local_search_fixed, max_flips);
+    saved_phase = local_searcher->best_phases();
+    return found;
+}
+
+template <typename Policy>
+SolveResult BasicSolver<Policy>::solve_local(std::uint64_t max_flips) {
+    if (formula_unsatisfiable) {
+        return SolveResult::UNSATISFIABLE;
+    }
+    if (trail.level() > 0) {
+        backjump(0);
+    }
+    if (!unit_prop()) {
+        return refute();
+    }
+    if (!local_search(max_flips)) {
+        return SolveResult::UNKNOWN;
+    }
+
+    model.resize(2 * (std::size_t{variables.variable_count()} + 1));
+    for (VarId var = 1; var <= variables.variable_count(); var++) {
+        Value value = variables.var_val(var);
+        if (value == Value::UNASSIGNED) {
+            value = saved_phase[var - 1] ? Value::TRUE : Value::FALSE;
+        }
+        model[VarToLit(var, true)] = value;
+        model[VarToLit(var, false)] = Neg(value);
+    }
+    substituted.extend(model);
+    return SolveResult::SATISFIABLE;
+}
+
+
+#define INSTANTIATE(Policy) \
+    template bool BasicSolver<Policy>::local_search(std::uint64_t max_flips); \
+    template SolveResult BasicSolver<Policy>::solve_local(std::uint64_t max_flips);
+
+NIMMERSAT_FOR_EACH_POLICY(INSTANTIATE)
+
+#undef INSTANTIATE
+
+}  // namespace NimmerSAT
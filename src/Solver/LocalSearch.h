@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "NSatUtility.h"
+
+namespace NimmerSAT {
+
+// ProbSAT: repeatedly picks a random unsatisfied clause and flips one of
+// its variables with a probability falling polynomially in the number of
+// clauses the flip would break. Every clause keeps the number of its true
+// literals and the xor of their variables, which is the critical variable
+// once only one of them is left, so break counts are maintained per
+// variable instead of being recomputed. The unsatisfied clauses are kept in
+// a list with O(1) removal.
+//
+// The clauses and their occurrence lists are built once and reused by every
+// run, which only sets up the assignment, the true literal counts and the
+// break counts again. Variables the caller has fixed keep their value and
+// are never flipped, so a solver can keep the clauses of its formula while
+// its level 0 assignment grows.
+class LocalSearch final {
+public:
+
+    LocalSearch(std::uint32_t variable_count, std::uint64_t seed);
+
+    LocalSearch(const LocalSearch&) = delete;
+    LocalSearch(LocalSearch&&) = default;
+    LocalSearch& operator=(const LocalSearch&) = delete;
+    LocalSearch& operator=(LocalSearch&&) = default;
+    ~LocalSearch() = default;
+
+    // Adds a clause without its duplicate literals, tautologies are left
+    // out. Returns false for the empty clause.
+    bool add_clause(std::span<const LitId> literals);
+
+    // Starts from the polarities in phases, indexed by variable - 1, for the
+    // variables that fixed, indexed by variable, leaves unassigned, and
+    // flips until every clause is satisfied or max_flips is reached.
+    // Returns whether a model was found.
+    bool run(const std::vector<bool>& phases, const std::vector<Value>& fixed, std::uint64_t max_flips);
+
+    // The assignment of the last run with the fewest unsatisfied clauses.
+    inline const std::vector<bool>& best_phases() const {
+        return best;
+    }
+
+    inline std::size_t best_unsatisfied() const {
+        return best_unsatisfied_count;
+    }
+
+    inline std::uint64_t flip_count() const {
+        return flips;
+    }
+
+private:
+
+    // Builds the occurrence lists once all clauses are known.
+    void prepare();
+
+    // Counts true literals, critical variables, break counts and the
+    // unsatisfied clauses from scratch.
+    void initialize(const std::vector<bool>& phases, const std::vector<Value>& fixed);
+
+    void flip(VarId var);
+
+    // A variable of clause that is not fixed, or 0 if there is none.
+    VarId pick(std::uint32_t clause);
+
+    inline bool is_true(LitId lit) const {
+        return (values[LitToVar(lit)] != 0) == IsPositive(lit);
+    }
+
+    inline void make_unsatisfied(std::uint32_t clause) {
+        unsatisfied_position[clause] = static_cast<std::uint32_t>(unsatisfied.size());
+        unsatisfied.push_back(clause);
+    }
+
+    inline void make_satisfied(std::uint32_t clause) {
+        std::uint32_t last = unsatisfied.back();
+        unsatisfied[unsatisfied_position[clause]] = last;
+        unsatisfied_position[last] = unsatisfied_position[clause];
+        unsatisfied.pop_back();
+    }
+
+    // The best assignment is the current one with the flips since then
+    // undone, until too many flips have been made and it is copied out.
+    void save_best();
+
+    // Weights of the polynomial break distribution, (eps + break)^-cb.
+    constexpr static std::size_t MAX_BREAK = 64;
+
+    std::uint32_t variable_count;
+
+    std::mt19937_64 random;
+
+    // Clauses in CSR form, clause i spans literals[starts[i], starts[i+1]).
+    std::vector<LitId> literals;
+
+    std::vector<std::uint32_t> starts{0};
+
+    std::uint32_t max_clause_size = 0;
+
+    // Clauses containing each literal, in CSR form as well.
+    std::vector<std::uint32_t> occurrences;
+
+    std::vector<std::uint32_t> occurrence_starts;
+
+    std::vector<std::uint64_t> literal_stamp;
+
+    std::uint64_t current_stamp = 0;
+
+    // Polarity per variable, index 0 unused.
+    std::vector<std::uint8_t> values;
+
+    std::vector<std::uint8_t> is_fixed;
+
+    std::vector<std::uint32_t> true_count;
+
+    std::vector<VarId> critical;
+
+    std::vector<std::uint32_t> break_count;
+
+    std::vector<std::uint32_t> unsatisfied;
+
+    std::vector<std::uint32_t> unsatisfied_position;
+
+    std::array<double, MAX_BREAK + 1> weights{};
+
+    std::vector<double> candidate_weights;
+
+    std::vector<bool> best;
+
+    std::size_t best_unsatisfied_count = 0;
+
+    // Variables flipped since the best assignment while best_in_trail.
+    std::vector<VarId> trail;
+
+    bool best_in_trail = true;
+
+    std::uint64_t flips = 0;
+
+};
+
+}  // namespace NimmerSAT
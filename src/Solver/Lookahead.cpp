@@ -0,0 +1,170 @@
+
+#include "Assign.h"
+#include "NSatUtility.h"
+
+#include <algorithm>
+
+namespace NimmerSAT {
+
+template <typename Policy>
+std::vector<std::vector<LitId>> BasicSolver<Policy>::split(std::span<const LitId> prefix, std::uint32_t depth) {
+    std::vector<std::vector<LitId>> cubes;
+    if (formula_unsatisfiable) {
+        return cubes;
+    }
+    if (trail.level() > 0) {
+        backjump(0);
+    }
+    if (!unit_prop()) {
+        refute();
+        return cubes;
+    }
+
+    // Variables occurring most often are the candidates for splitting.
+    std::vector<std::uint32_t> occurrences(variables.variable_count() + 1, 0);
+    for (ClauseId clause_id : clauses) {
+        if (!clauses[clause_id].deleted()) {
+            for (LitId lit : clauses[clause_id]) {
+                occurrences[LitToVar(lit)]++;
+            }
+        }
+    }
+    std::vector<VarId> candidates;
+    for (VarId var = 1; var <= variables.variable_count(); var++) {
+        occurrences[var] += static_cast<std::uint32_t>(variables.binaries(VarToLit(var, true)).size() +
+                                                       variables.binaries(VarToLit(var, false)).size());
+        if (occurrences[var] > 0) {
+            candidates.push_back(var);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&](VarId a, VarId b) {
+        return occurrences[a] > occurrences[b];
+    });
+
+    std::vector<LitId> cube;
+    for (LitId assumption : prefix) {
+        LitId lit = equivalent[assumption];
+        if (variables.lit_val(lit) == Value::UNASSIGNED) {
+            decide(lit);
+            if (!unit_prop()) {
+                backjump(0);
+                return cubes;
+            }
+        } else if (variables.lit_val(lit) == Value::FALSE) {
+            backjump(0);
+            return cubes;
+        }
+        cube.push_back(assumption);
+    }
+
+    // Looking ahead must not overwrite the phases the search has saved.
+    std::vector<bool> phases = saved_phase;
+    split_node(cube, depth, candidates, cubes);
+    backjump(0);
+    saved_phase = std::move(phases);
+    return cubes;
+}
+
+template <typename Policy>
+void BasicSolver<Policy>::split_node(std::vector<LitId>& cube, std::uint32_t depth,
+                        std::span<const VarId> candidates, std::vector<std::vector<LitId>>& cubes) {
+    std::uint32_t level = trail.level();
+    std::size_t cube_size = cube.size();
+
+    for (;;) {
+        if (depth == 0) {
+            cubes.push_back(cube);
+            break;
+        }
+
+        // Branch on the variable whose polarities propagate the most, as
+        // measured by the product of both counts. A failed literal forces
+        // its negation, which is added to the cube before looking again.
+        std::optional<LitId> forced;
+        VarId best = 0;
+        std::size_t best_score = 0;
+        std::size_t probed = 0;
+        bool refuted = false;
+        for (VarId var : candidates) {
+            if (probed == options.lookahead_candidates) {
+                break;
+            }
+            if (variables.var_val(var) != Value::UNASSIGNED) {
+                continue;
+            }
+            probed++;
+            std::optional<std::size_t> positive = lookahead(VarToLit(var, true));
+            std::optional<std::size_t> negative = lookahead(VarToLit(var, false));
+            if (!positive && !negative) {
+                refuted = true;
+                break;
+            }
+            if (!positive || !negative) {
+                forced = VarToLit(var, positive.has_value());
+                break;
+            }
+            if (std::size_t score = (*positive + 1) * (*negative + 1); score > best_score) {
+                best = var;
+                best_score = score;
+            }
+        }
+
+        if (refuted) {
+            break;
+        }
+        if (forced) {
+            decide(*forced);
+            if (!unit_prop()) {
+                break;
+            }
+            cube.push_back(*forced);
+            continue;
+        }
+        // Everything is assigned without conflict, the cube is a model.
+        if (best == 0) {
+            cubes.push_back(cube);
+            break;
+        }
+
+        std::uint32_t node_level = trail.level();
+        for (LitId lit : {VarToLit(best, true), VarToLit(best, false)}) {
+            decide(lit);
+            if (unit_prop()) {
+                cube.push_back(lit);
+                split_node(cube, depth - 1, candidates, cubes);
+                cube.pop_back();
+            }
+            backjump(node_level);
+        }
+        break;
+    }
+
+    backjump(level);
+    cube.resize(cube_size);
+}
+
+template <typename Policy>
+std::optional<std::size_t> BasicSolver<Policy>::lookahead(LitId lit) {
+    std::uint32_t level = trail.level();
+    std::size_t start = trail.size();
+    decide(lit);
+    bool consistent = unit_prop();
+    std::size_t assigned = trail.size() - start;
+    backjump(level);
+    if (!consistent) {
+        return std::nullopt;
+    }
+    return assigned;
+}
+
+
+#define INSTANTIATE(Policy) \
+    template std::vector<std::vector<LitId>> BasicSolver<Policy>::split(std::span<const LitId> prefix, std::uint32_t depth); \
+    template void BasicSolver<Policy>::split_node(std::vector<LitId>& cube, std::uint32_t depth, std::span<const VarId> candidates, std::vector<std::vector<LitId>>& cubes); \
+    template std::optional<std::size_t> BasicSolver<Policy>::lookahead(LitId lit);
+
+NIMMERSAT_FOR_EACH_POLICY(INSTANTIATE)
+
+#undef INSTANTIATE
+
+}  // namespace NimmerSAT
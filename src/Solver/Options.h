@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace NimmerSAT {
+
+enum class DecisionHeuristic {
+    SCAN,   // Lowest unassigned variable
+    VSIDS
+};
+
+enum class RestartPolicy {
+    NONE,
+    LUBY,
+    GLUCOSE   // Moving averages of the LBD of learnt clauses
+};
+
+struct SolverOptions {
+    DecisionHeuristic decision = DecisionHeuristic::VSIDS;
+
+    // Activity of variables not bumped decays by this factor per conflict.
+    double var_decay = 0.95;
+
+    RestartPolicy restart = RestartPolicy::GLUCOSE;
+
+    // Conflicts per unit of the Luby sequence.
+    std::uint64_t luby_unit = 100;
+
+    // Glucose restarts trigger once the fast LBD average exceeds the slow
+    // one by this factor.
+    double restart_margin = 1.25;
+
+    // Learnt clauses with an LBD up to core_lbd are kept forever, those up
+    // to tier2_lbd are kept as long as they keep being used. All others
+    // compete for survival by LBD and activity.
+    std::uint32_t core_lbd = 2;
+    std::uint32_t tier2_lbd = 6;
+
+    // Conflicts before the first reduction and the growth of the interval.
+    std::uint64_t reduce_first = 2000;
+    std::uint64_t reduce_increment = 300;
+
+    double clause_decay = 0.999;
+
+    // Failed literal probing and equivalent literal substitution before the
+    // search and at the first restart after every interval of conflicts.
+    bool inprocessing = true;
+    std::uint64_t inprocess_interval = 20000;
+
+    // Assignments made while probing per inprocessing round.
+    std::uint64_t probe_budget = 1'000'000;
+
+    // ProbSAT local search from the saved phases, which are then replaced
+    // by the best assignment found. Runs before the search and at the first
+    // restart after every interval of conflicts.
+    bool local_search = true;
+    std::uint64_t local_search_interval = 10'000;
+    std::uint64_t local_search_flips = 100'000;
+
+    // Variables evaluated by lookahead per node when splitting into cubes.
+    std::uint32_t lookahead_candidates = 32;
+
+    // Chronological backtracking: a learnt clause that would backjump over
+    // more than this many levels only backtracks one level, keeping the
+    // assignments below as they are. Zero always backjumps.
+    std::uint32_t chrono_levels = 100;
+
+    // Gauss-Jordan elimination over the XOR constraints of up to
+    // xor_max_size variables found in the clauses, next to clause
+    // propagation. Turned off while a proof is written, its implications are
+    // not RUP.
+    bool gaussian_elimination = true;
+    std::uint32_t xor_max_size = 6;
+
+    // Reuse the last polarity of a variable instead of always branching
+    // positive.
+    bool phase_saving = true;
+
+    // Polarity of variables before they were assigned for the first time.
+    bool initial_phase = true;
+
+    // Nonzero seeds randomize the initial variable order.
+    std::uint64_t seed = 0;
+
+    // Learnt clauses up to this LBD, and all binary and unit clauses, are
+    // shared with the other solvers of a portfolio.
+    std::uint32_t share_lbd = 2;
+
+    // Solve with the variant compiled for these settings if there is one,
+    // see Policy.h, rather than reading all of them at runtime.
+    bool fixed_policy = true;
+};
+
+// Limits of the search, counted from the moment they are handed to the
+// solver. A solve() call running out of any of them returns UNKNOWN, and a
+// later call with a new budget continues from there.
+struct SolveBudget {
+    constexpr static std::uint64_t UNLIMITED = std::numeric_limits<std::uint64_t>::max();
+
+    std::uint64_t conflicts = UNLIMITED;
+    std::uint64_t propagations = UNLIMITED;
+
+    // Wall clock time.
+    double seconds = std::numeric_limits<double>::infinity();
+
+    // Estimated memory of the clauses and of the per variable arrays.
+    std::uint64_t memory_bytes = UNLIMITED;
+};
+
+}  // namespace NimmerSAT
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <optional>
+
+#include "Options.h"
+
+namespace NimmerSAT {
+
+// Policies fix parts of the solver configuration at compile time, in the
+// spirit of Debug() and Stats(). A setting that is nullopt is read from the
+// SolverOptions at runtime, a fixed one replaces the option entirely and
+// lets the compiler drop the branches on it from the hot paths. Without
+// proof, everything recording DRAT lemmas is compiled out and set_proof()
+// has no effect. Without gaussian_elimination, the XOR constraints of the
+// formula are not looked for and the engine is compiled out of assignment,
+// unassignment and propagation.
+
+// Every setting taken from the options. Used wherever the configuration is
+// only known at runtime, e.g. through IPASIR.
+struct RuntimePolicy {
+    constexpr static std::optional<DecisionHeuristic> decision = std::nullopt;
+    constexpr static std::optional<RestartPolicy> restart = std::nullopt;
+    constexpr static std::optional<bool> phase_saving = std::nullopt;
+    constexpr static bool proof = true;
+    constexpr static std::optional<bool> gaussian_elimination = std::nullopt;
+};
+
+// The default options without proof logging, on a formula without XOR
+// constraints.
+struct DefaultPolicy {
+    constexpr static std::optional<DecisionHeuristic> decision = DecisionHeuristic::VSIDS;
+    constexpr static std::optional<RestartPolicy> restart = RestartPolicy::GLUCOSE;
+    constexpr static std::optional<bool> phase_saving = true;
+    constexpr static bool proof = false;
+    constexpr static std::optional<bool> gaussian_elimination = false;
+};
+
+// The default options without proof logging, on a formula with XOR
+// constraints.
+struct XorPolicy {
+    constexpr static std::optional<DecisionHeuristic> decision = DecisionHeuristic::VSIDS;
+    constexpr static std::optional<RestartPolicy> restart = RestartPolicy::GLUCOSE;
+    constexpr static std::optional<bool> phase_saving = true;
+    constexpr static bool proof = false;
+    constexpr static std::optional<bool> gaussian_elimination = true;
+};
+
+// The default options with Luby restarts, as diversified in a portfolio.
+struct LubyPolicy {
+    constexpr static std::optional<DecisionHeuristic> decision = DecisionHeuristic::VSIDS;
+    constexpr static std::optional<RestartPolicy> restart = RestartPolicy::LUBY;
+    constexpr static std::optional<bool> phase_saving = true;
+    constexpr static bool proof = false;
+    constexpr static std::optional<bool> gaussian_elimination = false;
+};
+
+// The policies the solver is compiled with. Every other combination runs
+// with RuntimePolicy.
+#define NIMMERSAT_FOR_EACH_POLICY(X) \
+    X(RuntimePolicy)                 \
+    X(DefaultPolicy)                 \
+    X(XorPolicy)                     \
+    X(LubyPolicy)
+
+// Whether Policy fixes its settings to those of options, and supports
+// proofs if one is written. Gaussian elimination is fixed on if options
+// enable it and the formula has XOR constraints, see FindXors.
+template <typename Policy>
+constexpr bool Matches(const SolverOptions& options, bool proof, bool xors) {
+    return options.fixed_policy &&
+        (!Policy::decision || *Policy::decision == options.decision) &&
+        (!Policy::restart || *Policy::restart == options.restart) &&
+        (!Policy::phase_saving || *Policy::phase_saving == options.phase_saving) &&
+        (Policy::proof || !proof) &&
+        (!Policy::gaussian_elimination || *Policy::gaussian_elimination == (options.gaussian_elimination && xors));
+}
+
+// Calls run with a value of the first fixed policy matching options, or of
+// RuntimePolicy if none does or options.fixed_policy is off. All calls of
+// run must return the same type.
+template <typename Run>
+decltype(auto) WithPolicy(const SolverOptions& options, bool proof, bool xors, Run&& run) {
+    if (Matches<DefaultPolicy>(options, proof, xors)) {
+        return run(DefaultPolicy{});
+    }
+    if (Matches<XorPolicy>(options, proof, xors)) {
+        return run(XorPolicy{});
+    }
+    if (Matches<LubyPolicy>(options, proof, xors)) {
+        return run(LubyPolicy{});
+    }
+    return run(RuntimePolicy{});
+}
+
+}  // namespace NimmerSAT
@@ -0,0 +1,127 @@
+
+#include "Portfolio.h"
+
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace NimmerSAT {
+
+namespace {
+
+// Calls visit with the solver held by pointer, unless none was built.
+template <typename Pointer, typename Visit>
+void VisitSolver(Pointer& pointer, Visit&& visit) {
+    std::visit([&](auto &solver) {
+        if constexpr (!std::is_same_v<std::decay_t<decltype(solver)>, std::monostate>) {
+            visit(*solver);
+        }
+    }, pointer);
+}
+
+}  // namespace
+
+Portfolio::Portfolio(std::uint32_t variable_count, ClauseCache formula,
+                     SolverOptions options, std::uint32_t thread_count) :
+    variable_count(variable_count),
+    formula(std::move(formula)),
+    options(options),
+    solvers(thread_count),
+    exchange(thread_count)
+{
+}
+
+SolveResult Portfolio::solve() {
+    bool xors = options.gaussian_elimination && !FindXors(formula, options.xor_max_size).empty();
+
+    // The copies are made before any solver starts to write to its arena.
+    std::vector<ClauseCache> arenas;
+    arenas.reserve(solvers.size());
+    for (std::uint32_t index = 0; index + 1 < solvers.size(); index++) {
+        arenas.push_back(formula.clone());
+    }
+    arenas.push_back(std::move(formula));
+
+    std::vector<std::thread> threads;
+    for (std::uint32_t index = 0; index < solvers.size(); index++) {
+        threads.emplace_back([this, index, xors, &arenas] {
+            SolverOptions solver_options = Diversify(options, index);
+            WithPolicy(solver_options, false, xors, [&](auto policy) {
+                run<decltype(policy)>(index, solver_options, std::move(arenas[index]));
+            });
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return result;
+}
+
+template <typename Policy>
+void Portfolio::run(std::uint32_t index, SolverOptions solver_options, ClauseCache clauses) {
+    auto &pointer = solvers[index].emplace<std::unique_ptr<BasicSolver<Policy>>>(
+        std::make_unique<BasicSolver<Policy>>(variable_count, std::move(clauses), solver_options));
+    BasicSolver<Policy> &solver = *pointer;
+    solver.set_terminate(&finished);
+    solver.connect(exchange, index);
+
+    SolveResult answer = solver.solve();
+    if (answer != SolveResult::UNKNOWN && !finished.exchange(true)) {
+        winner_index = index;
+        result = answer;
+    }
+}
+
+void Portfolio::extend_model(const ModelReconstruction& reconstruction) {
+    VisitSolver(solvers[winner_index], [&](auto &solver) {
+        solver.extend_model(reconstruction);
+    });
+}
+
+void Portfolio::print() const {
+    VisitSolver(solvers[winner_index], [](const auto &solver) {
+        solver.print();
+    });
+}
+
+SearchStatistics Portfolio::statistics() const {
+    SearchStatistics total;
+    for (const auto &pointer : solvers) {
+        VisitSolver(pointer, [&](const auto &solver) {
+            total += solver.statistics();
+        });
+    }
+    return total;
+}
+
+SolverOptions Portfolio::Diversify(SolverOptions options, std::uint32_t index) {
+    if (index == 0) {
+        return options;
+    }
+    options.seed = index;
+
+    switch (index % 4) {
+        case 1:
+            options.restart = RestartPolicy::LUBY;
+            break;
+
+        case 2:
+            options.initial_phase = !options.initial_phase;
+            break;
+
+        case 3:
+            options.var_decay = 0.85;
+            options.restart_margin = 1.15;
+            break;
+
+        default:
+            options.tier2_lbd = 8;
+            break;
+    }
+    if (index % 8 >= 4) {
+        options.inprocessing = !options.inprocessing;
+    }
+    return options;
+}
+
+}  // namespace NimmerSAT
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <variant>
+#include <vector>
+
+#include "Formula/FormulaCache.h"
+#include "Assign.h"
+#include "Exchange.h"
+#include "Options.h"
+#include "Policy.h"
+
+namespace NimmerSAT {
+
+// Runs differently configured solvers on the same formula in parallel.
+// They share short and low LBD learnt clauses, and the first one to find an
+// answer stops all others. Every solver is compiled for the policy matching
+// its diversified options where there is one, so the portfolio mixes
+// variants.
+//
+// Every solver owns a copy of the formula's arena. A single shared arena
+// would have to stay immutable, but a solver writes to its own: watching
+// swaps the literals of a clause in place to keep the two watched ones in
+// front, inprocessing strengthens and deletes irredundant clauses, learnt
+// clauses are appended to it, and garbage collection compacts it, which
+// moves the clauses the watchers and reasons refer to. Sharing would need
+// watch positions stored apart from the literals and a second arena per
+// solver for its own clauses, so the copy is kept. The formula is moved
+// into the last solver, so N threads hold N copies and not N + 1, which
+// --help states under --threads.
+class Portfolio final {
+public:
+
+    Portfolio(std::uint32_t variable_count, ClauseCache formula,
+              SolverOptions options, std::uint32_t thread_count);
+
+    Portfolio(const Portfolio&) = delete;
+    Portfolio& operator=(const Portfolio&) = delete;
+
+    ~Portfolio() = default;
+
+    SolveResult solve();
+
+    // Assigns the variables removed by preprocessing in the model of the
+    // solver that found it.
+    void extend_model(const ModelReconstruction& reconstruction);
+
+    // Prints the model of the solver that found it.
+    void print() const;
+
+    // Sum of the statistics of all solvers.
+    SearchStatistics statistics() const;
+
+private:
+
+    // Options of the solver with the given index. Solver 0 keeps the options
+    // as they are.
+    static SolverOptions Diversify(SolverOptions options, std::uint32_t index);
+
+    // Solves clauses with the solver of the given index.
+    template <typename Policy>
+    void run(std::uint32_t index, SolverOptions solver_options, ClauseCache clauses);
+
+    // A solver of any of the compiled policies, or none before it is built.
+    #define NIMMERSAT_SOLVER_POINTER(Policy) , std::unique_ptr<BasicSolver<Policy>>
+    using SolverPointer = std::variant<std::monostate NIMMERSAT_FOR_EACH_POLICY(NIMMERSAT_SOLVER_POINTER)>;
+    #undef NIMMERSAT_SOLVER_POINTER
+
+    std::uint32_t variable_count;
+
+    // Moved out by solve().
+    ClauseCache formula;
+
+    SolverOptions options;
+
+    std::vector<SolverPointer> solvers;
+
+    ClauseExchange exchange;
+
+    std::atomic<bool> finished{false};
+
+    std::uint32_t winner_index = 0;
+
+    SolveResult result = SolveResult::UNKNOWN;
+
+};
+
+}  // namespace NimmerSAT
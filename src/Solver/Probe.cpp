@@ -0,0 +1,409 @@
+
+#include "Assign.h"
+#include "NSatUtility.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace NimmerSAT {
+
+template <typename Policy>
+bool BasicSolver<Policy>::inprocess() {
+    return probe() && substitute_equivalences() && build_gauss();
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::build_gauss() {
+    gauss_stale = false;
+    if (xors.empty() || logging()) {
+        return true;
+    }
+    std::vector<LitId> units;
+    if (!gauss.build(xors, equivalent, variables, units)) {
+        return false;
+    }
+    for (LitId unit : units) {
+        if (!add_unit(unit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::probe() {
+    // Probing assigns and unassigns every candidate, which must not
+    // overwrite the phases the search has saved.
+    std::vector<bool> phases = saved_phase;
+    std::uint64_t budget_end = propagations + options.probe_budget;
+
+    VarId count = variables.variable_count();
+    for (VarId i = 0; i < count && propagations < budget_end; i++) {
+        VarId var = probe_position;
+        probe_position = probe_position == count ? 1 : probe_position + 1;
+
+        // Only variables in binary clauses can imply anything cheaply.
+        if (variables.var_val(var) != Value::UNASSIGNED ||
+            (variables.binaries(VarToLit(var, true)).empty() &&
+             variables.binaries(VarToLit(var, false)).empty())) {
+            continue;
+        }
+
+        if (!probe_variable(var)) {
+            saved_phase = std::move(phases);
+            return false;
+        }
+    }
+
+    saved_phase = std::move(phases);
+    return true;
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::probe_variable(VarId var) {
+    std::vector<LitId> implied_by_both;
+    current_stamp++;
+
+    for (LitId lit : {VarToLit(var, true), VarToLit(var, false)}) {
+        std::size_t start = trail.size();
+        decide(lit);
+        bool consistent = unit_prop();
+
+        if (consistent) {
+            for (std::size_t i = start + 1; i < trail.size(); i++) {
+                LitId implied = trail[i];
+                if (IsPositive(lit)) {
+                    literal_stamp[implied] = current_stamp;
+                } else if (literal_stamp[implied] == current_stamp) {
+                    implied_by_both.push_back(implied);
+                }
+            }
+        }
+        backjump(0);
+
+        // A failed literal fixes the variable, nothing else is learnt.
+        if (!consistent) {
+            return add_unit(Neg(lit));
+        }
+    }
+
+    for (LitId lit : implied_by_both) {
+        // The unit is the resolvent of the two implications, which unit
+        // propagation alone does not find.
+        std::array<LitId, 2> positive{VarToLit(var, false), lit};
+        std::array<LitId, 2> negative{VarToLit(var, true), lit};
+        if (logging()) {
+            proof->add(positive);
+            proof->add(negative);
+        }
+        bool consistent = add_unit(lit);
+        if (logging()) {
+            proof->remove(positive);
+            proof->remove(negative);
+        }
+        if (!consistent) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::add_unit(LitId lit) {
+    if (variables.lit_val(lit) != Value::UNASSIGNED) {
+        return variables.lit_val(lit) == Value::TRUE;
+    }
+    if (logging()) {
+        proof->add(std::span<const LitId>(&lit, 1));
+    }
+    assign(lit, NO_CLAUSE);
+    return unit_prop();
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::substitute_equivalences() {
+    std::vector<LitId> representative;
+    if (!equivalent_literals(representative)) {
+        return false;
+    }
+
+    bool substituted_any = false;
+    for (VarId var = 1; var <= variables.variable_count(); var++) {
+        LitId lit = VarToLit(var, true);
+        LitId repr = representative[lit];
+        if (repr == lit) {
+            continue;
+        }
+        // Both directions of the equivalence are needed to restore the
+        // value of the substituted variable from its representative.
+        std::array<LitId, 2> implication{lit, Neg(repr)};
+        substituted.push(lit, implication);
+        implication = {Neg(lit), repr};
+        substituted.push(Neg(lit), implication);
+        substituted_any = true;
+    }
+
+    if (!substituted_any) {
+        return true;
+    }
+    for (LitId &lit : equivalent) {
+        lit = representative[lit];
+    }
+    return rebuild_clauses(representative);
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::equivalent_literals(std::vector<LitId>& representative) {
+    std::size_t literal_count = 2 * (std::size_t{variables.variable_count()} + 1);
+    representative.resize(literal_count);
+    for (LitId lit = 0; lit < literal_count; lit++) {
+        representative[lit] = lit;
+    }
+
+    // Iterative Tarjan over the unassigned literals. The implication graph
+    // is symmetric, so the component of the negation of a literal is the
+    // negation of its component and both pick negated representatives.
+    constexpr std::uint32_t UNVISITED = 0;
+    std::vector<std::uint32_t> index(literal_count, UNVISITED);
+    std::vector<std::uint32_t> lowlink(literal_count, 0);
+    std::vector<bool> on_stack(literal_count, false);
+    std::vector<LitId> component_stack;
+    std::vector<std::pair<LitId, std::size_t>> call_stack;
+    std::uint32_t next_index = 1;
+
+    for (LitId root = 2; root < literal_count; root++) {
+        if (index[root] != UNVISITED || variables.lit_val(root) != Value::UNASSIGNED) {
+            continue;
+        }
+
+        call_stack.emplace_back(root, 0);
+        while (!call_stack.empty()) {
+            auto &[lit, edge] = call_stack.back();
+            if (edge == 0) {
+                index[lit] = lowlink[lit] = next_index++;
+                component_stack.push_back(lit);
+                on_stack[lit] = true;
+            }
+
+            const auto &implied = variables.binaries(lit);
+            bool descended = false;
+            while (edge < implied.size()) {
+                LitId next = implied[edge++];
+                if (variables.lit_val(next) != Value::UNASSIGNED) {
+                    continue;
+                }
+                if (index[next] == UNVISITED) {
+                    call_stack.emplace_back(next, 0);
+                    descended = true;
+                    break;
+                }
+                if (on_stack[next]) {
+                    lowlink[lit] = std::min(lowlink[lit], index[next]);
+                }
+            }
+            if (descended) {
+                continue;
+            }
+
+            LitId finished = lit;
+            call_stack.pop_back();
+            if (!call_stack.empty()) {
+                LitId parent = call_stack.back().first;
+                lowlink[parent] = std::min(lowlink[parent], lowlink[finished]);
+            }
+            if (lowlink[finished] != index[finished]) {
+                continue;
+            }
+
+            // The component is on top of the stack, searching from the top
+            // keeps the search within its size.
+            auto component = std::prev(std::find(component_stack.rbegin(), component_stack.rend(), finished).base());
+            LitId repr = *std::min_element(component, component_stack.end());
+            for (auto it = component; it != component_stack.end(); it++) {
+                on_stack[*it] = false;
+                representative[*it] = repr;
+                if (representative[Neg(*it)] == repr) {
+                    // The literal implies its own negation.
+                    if (logging()) {
+                        LitId unit = Neg(*it);
+                        proof->add(std::span<const LitId>(&unit, 1));
+                    }
+                    return false;
+                }
+            }
+            component_stack.erase(component, component_stack.end());
+        }
+    }
+    return true;
+}
+
+template <typename Policy>
+bool BasicSolver<Policy>::rebuild_clauses(const std::vector<LitId>& representative) {
+    local_search_stale = true;
+
+    // Reasons of level 0 assignments are never analyzed, and the clauses
+    // they point to may be removed below. The proof keeps the assignments
+    // as units instead.
+    for (const LitId &lit : trail) {
+        variables.set_reason(LitToVar(lit), NO_CLAUSE);
+        if (logging()) {
+            proof->add(std::span<const LitId>(&lit, 1));
+        }
+    }
+
+    std::vector<LitId> units;
+    std::vector<LitId> literals;
+    bool empty_clause = false;
+
+    // Maps the literals of a clause into literals, returning false if the
+    // clause is satisfied at level 0 or a tautology.
+    auto simplify = [&](std::span<const LitId> clause) {
+        current_stamp++;
+        literals.clear();
+        for (LitId original : clause) {
+            LitId lit = representative[original];
+            Value value = variables.lit_val(lit);
+            if (value == Value::TRUE || literal_stamp[Neg(lit)] == current_stamp) {
+                return false;
+            }
+            if (value == Value::UNASSIGNED && literal_stamp[lit] != current_stamp) {
+                literal_stamp[lit] = current_stamp;
+                literals.push_back(lit);
+            }
+        }
+        return true;
+    };
+
+    // Rewritten clauses are implied by the originals together with the
+    // binary clauses of the equivalences, so the originals are only deleted
+    // from the proof once everything has been rewritten.
+    std::vector<std::array<LitId, 2>> removed_binaries;
+    std::vector<ClauseId> removed_clauses;
+    auto record = [&](std::span<const LitId> original, bool keep) {
+        if (!logging()) {
+            return;
+        }
+        if (keep && literals.size() == original.size() &&
+            std::equal(literals.begin(), literals.end(), original.begin())) {
+            return;
+        }
+        if (keep) {
+            proof->add(literals);
+        }
+        if (original.size() == 2) {
+            removed_binaries.push_back({original[0], original[1]});
+        }
+    };
+
+    std::vector<std::pair<LitId, LitId>> binaries;
+    for (LitId lit = 2; lit < representative.size(); lit++) {
+        for (LitId implied : variables.binaries(lit)) {
+            LitId other = Neg(lit);
+            if (other > implied) {
+                continue;
+            }
+            std::array<LitId, 2> clause{other, implied};
+            bool keep = simplify(clause);
+            record(clause, keep);
+            if (!keep) {
+                continue;
+            }
+            if (literals.size() == 2) {
+                binaries.emplace_back(std::min(literals[0], literals[1]), std::max(literals[0], literals[1]));
+            } else if (literals.size() == 1) {
+                units.push_back(literals[0]);
+            } else {
+                empty_clause = true;
+            }
+        }
+    }
+    std::sort(binaries.begin(), binaries.end());
+    binaries.erase(std::unique(binaries.begin(), binaries.end()), binaries.end());
+
+    variables.clear_clauses();
+    binary_clause_count = 0;
+    for (auto [first, second] : binaries) {
+        variables.add_binary(first, second);
+        binary_clause_count++;
+    }
+
+    // Rewritten clauses are appended behind the end of the iteration.
+    for (ClauseId clause_id : clauses) {
+        Clause clause = clauses[clause_id];
+        if (clause.deleted()) {
+            continue;
+        }
+
+        bool keep = simplify(clause.literals());
+        if (keep && literals.size() == clause.size() &&
+            std::equal(literals.begin(), literals.end(), clause.begin())) {
+            continue;
+        }
+
+        record(clause.literals(), keep);
+        if (logging()) {
+            removed_clauses.push_back(clause_id);
+        }
+        bool learnt = clause.learnt();
+        std::uint32_t lbd = clause.lbd();
+        clauses.remove(clause_id);
+        if (!keep) {
+            continue;
+        }
+        if (literals.size() > 2) {
+            clauses.add(literals, learnt, std::min<std::uint32_t>(lbd, static_cast<std::uint32_t>(literals.size())));
+        } else if (literals.size() == 2) {
+            variables.add_binary(literals[0], literals[1]);
+            binary_clause_count++;
+        } else if (literals.size() == 1) {
+            units.push_back(literals[0]);
+        } else {
+            empty_clause = true;
+        }
+    }
+
+    for (ClauseId clause_id : clauses) {
+        Clause clause = clauses[clause_id];
+        if (!clause.deleted()) {
+            variables.watch(clause[0], Watcher{clause_id, clause[1]});
+            variables.watch(clause[1], Watcher{clause_id, clause[0]});
+        }
+    }
+    if (logging()) {
+        for (const auto &binary : removed_binaries) {
+            proof->remove(binary);
+        }
+        for (ClauseId clause_id : removed_clauses) {
+            proof->remove(clauses[clause_id].literals());
+        }
+    }
+    collect_garbage();
+
+    if (empty_clause) {
+        return false;
+    }
+    for (LitId unit : units) {
+        if (!add_unit(unit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+#define INSTANTIATE(Policy) \
+    template bool BasicSolver<Policy>::inprocess(); \
+    template bool BasicSolver<Policy>::build_gauss(); \
+    template bool BasicSolver<Policy>::probe(); \
+    template bool BasicSolver<Policy>::probe_variable(VarId var); \
+    template bool BasicSolver<Policy>::add_unit(LitId lit); \
+    template bool BasicSolver<Policy>::substitute_equivalences(); \
+    template bool BasicSolver<Policy>::equivalent_literals(std::vector<LitId>& representative); \
+    template bool BasicSolver<Policy>::rebuild_clauses(const std::vector<LitId>& representative);
+
+NIMMERSAT_FOR_EACH_POLICY(INSTANTIATE)
+
+#undef INSTANTIATE
+
+}  // namespace NimmerSAT
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Options.h"
+#include "Policy.h"
+
+namespace NimmerSAT {
+
+// Decides after which conflicts the search is restarted from level 0, by
+// the policy fixed by Policy or else by the one in the options.
+template <typename Policy>
+class RestartScheduler final {
+public:
+
+    explicit RestartScheduler(const SolverOptions& options) :
+        policy(options.restart),
+        luby_unit(options.luby_unit),
+        margin(options.restart_margin)
+    {
+    }
+
+    inline void on_conflict(std::uint32_t lbd) {
+        conflicts++;
+        fast_lbd.update(lbd);
+        slow_lbd.update(lbd);
+    }
+
+    inline bool should_restart() const {
+        switch (restart_policy()) {
+            case RestartPolicy::NONE:
+                return false;
+
+            case RestartPolicy::LUBY:
+                return conflicts >= luby_unit * Luby(restarts + 1);
+
+            case RestartPolicy::GLUCOSE:
+                // Restart while recently learnt clauses are noticeably worse
+                // than the long-term average.
+                return conflicts >= MIN_CONFLICTS &&
+                    fast_lbd.value() > margin * slow_lbd.value();
+        }
+        return false;
+    }
+
+    inline void on_restart() {
+        restarts++;
+        conflicts = 0;
+    }
+
+    inline std::uint64_t restart_count() const {
+        return restarts;
+    }
+
+    // 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ...
+    static std::uint64_t Luby(std::uint64_t i) {
+        for (;;) {
+            std::uint64_t k = 1;
+            while ((std::uint64_t{1} << k) - 1 < i) {
+                k++;
+            }
+            if (i == (std::uint64_t{1} << k) - 1) {
+                return std::uint64_t{1} << (k - 1);
+            }
+            i -= (std::uint64_t{1} << (k - 1)) - 1;
+        }
+    }
+
+private:
+
+    inline RestartPolicy restart_policy() const {
+        if constexpr (Policy::restart.has_value()) {
+            return *Policy::restart;
+        } else {
+            return policy;
+        }
+    }
+
+    // Exponential moving average with bias correction for the first values.
+    class MovingAverage final {
+    public:
+
+        explicit MovingAverage(double alpha) : alpha(alpha) {
+        }
+
+        inline void update(double sample) {
+            biased += alpha * (sample - biased);
+            correction *= 1.0 - alpha;
+        }
+
+        inline double value() const {
+            return correction == 1.0 ? 0.0 : biased / (1.0 - correction);
+        }
+
+    private:
+
+        double alpha;
+        double biased = 0.0;
+        double correction = 1.0;
+    };
+
+    constexpr static std::uint64_t MIN_CONFLICTS = 50;
+
+    RestartPolicy policy;
+    std::uint64_t luby_unit;
+    double margin;
+
+    std::uint64_t conflicts = 0;
+    std::uint64_t restarts = 0;
+
+    MovingAverage fast_lbd{1.0 / 32};
+    MovingAverage slow_lbd{1.0 / 100000};
+
+};
+
+}  // namespace NimmerSAT
@@ -1,228 +1,138 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
-#include <deque>
 
 #include "NSatUtility.h"
-#include "Formula/VariableCache.h"
-#incldue "Formula/ClauseCache.h"
-
 
 namespace NimmerSAT {
 
-class Assignment {
-private:
-
-    void unassign_literal(LitId lit) {
-        for (auto& clause_literal : variables.lit_pos_occ(lit)) {
-            auto &clause = clauses[clause_literal.first];
-            clause.active_literal_count++;
-            if (clause.satisfied_index = clause_literal.second) {
-                clause.satisfied_index = Clause::UNSATISFIED;
-            }
-
-            if constexpr (Debug()) {
-                clause.sanitize();
-            }
-        }
-
-        for (auto &clause_literal : variables.lit_neg_occ(lit)) {
-            auto &clause = clauses[clause_literal.first];
-            clause.active_literal_count++;
+// The trail of assigned literals, which doubles as the propagation queue.
+// Literals are appended as soon as they are assigned and propagated later,
+// in order, from the head. Every variable is on the trail at most once, so
+// the storage is allocated for all variables up front. The start of every
+// decision level is recorded, which turns backjumping into a truncation.
+// After chronological backtracking a literal may be assigned at a lower
+// level than the one it is stacked on, but never at a higher one.
+class AssignmentStack final {
+public:
 
-            if constexpr(Debug()) {
-                clause.sanitize();
-            }
-        }
+    explicit AssignmentStack(std::uint32_t variable_count) :
+        literals(variable_count)
+    {
     }
 
-    bool assign_literal(LitId lit) {
-        if constexpr (Debug()) {
-            if (variables.lit_val(lit) == VALUE::FALSE) {
-                std::stringstream str;
-                str << "Literal " << lit << " already set to false.";
-                Error(str);
-            }
-        }
-
-        if (variables.lit_val(lit) == Value::TRUE) {
-            return true;
-        }
-        
-        variables.set_lit(lit);
-
-        for (const auto &clause_literal : variables.lit_pos_occ(lit)) {
-            auto &clause = clauses[clause_literal.first];
-            clause.active_literal_count--;
-            if (clause.satisfied_index == Clause::UNSATISFIED) {
-                clause.satisfied_index = clause_literal.second;
-            }
+    AssignmentStack(const AssignmentStack&) = delete;
+    AssignmentStack(AssignmentStack&&) = default;
 
-            if constexpr (Debug()) {
-                clause.sanitize();
-            }
-        }
+    AssignmentStack& operator=(const AssignmentStack&) = delete;
+    AssignmentStack& operator=(AssignmentStack&&) = default;
 
-        bool conflict_detected = false;
-        for (const auto &clause_literal : variables.lit_neg_occ(lit)) {
-            auto &clause = clauses[clause_literal.first];
-            clause.active_literal_count--;
-            if (!clause.satisfied()) {
-                switch(clause.active_literals()) {
-                    case 0:
-                        conflict_detected = true;
-                        break;
-
-                    case 1:
-                        if (!conflict_detected) {
-                            for (LitId lit : clause.literals) {
-                                if (variables.lit_val(lit) == Value::UNASSIGNED) {
-                                    unit_queue.push_back(lit);
-                                    break;
-                                }
-                            }
-                        }
-                        break;
-                }
-            }
+    ~AssignmentStack() = default;
 
-            if constexpr (Debug()) {
-                clause.sanitize();
-            }
+    // Makes room for variables up to variable_count.
+    void grow(std::uint32_t variable_count) {
+        if (variable_count > literals.size()) {
+            literals.resize(variable_count);
         }
-        return !conflict_detected;
     }
 
-    bool negate_literal(LitId lit) {
-        for (auto &clause_literal : variables.lit_pos_occ(lit)) {
-            auto &clause = clauses[clause_literal.first]
-            if (clause.satisfied_index == clause_literal.second) {
-                clause.satisfied_index = Clause::UNSATISFIED;
-            }
-
-            if (!clause.satisfied()) {
-                if (clause.active_literals() == 1) {
-                    for (LitId l : clause.literals) {
-                        if (variables.lit_val(l) == Value::UNASSIGNED) {
-                            unit_queue.push_back(l);
-                            break;
-                        }
-                    }
-                }
-            }
-
-            if constexpr (Debug()) {
-                if (clause.active_literals() == 0) {
-                    Error("Negating literal leads to conflict");
-                }
-                clause.sanitize();
-            }
-        }
-
-        for (auto &clause_literal : variables.lit_neg_occ(lit)) {
-            auto &clause = clauses[clause_literal.first];
-            if (!clause.satisfied()) {
-                clause.satisfied_index == clause_literal.second;
-            }
+    // Empties the trail for a formula with variable_count variables.
+    void reset(std::uint32_t variable_count) {
+        literals.resize(variable_count);
+        top = 0;
+        head = 0;
+        level_starts.clear();
+    }
 
-            if constexpr(Debug()) {
-                clause.sanitize();
-            }
-        }
+    inline std::size_t size() const {
+        return top;
+    }
 
-        variables.set_lit(-lit);
+    inline bool empty() const {
+        return top == 0;
     }
 
-    bool unit_prop() {
-        while(!unit_queue.empty()) {
-            LitId lit = unit_queue.front();
-            stack.push_back(StackEntry{Type::FORCED, lit});
-            if (!assign_literal(lit)) {
-                return false;
-            }
-            unit_queue.pop_front();
-        }
-        return true;
+    inline LitId operator[](std::size_t index) const {
+        return literals[index];
     }
 
-    std::vector<Assignment> stack;
-    std::deque<LitId> unit_queue;
+    inline const LitId* begin() const {
+        return literals.data();
+    }
 
-    VariableCache& variables;
+    inline const LitId* end() const {
+        return literals.data() + top;
+    }
 
-public:
+    inline void push(LitId lit) {
+        literals[top++] = lit;
+    }
 
-    enum class Type {
-        BRANCHED,
-        FORCED,
-    };
+    // Number of decision levels on the trail. A level may be empty, see
+    // BasicSolver::solve().
+    inline std::uint32_t level() const {
+        return static_cast<std::uint32_t>(level_starts.size());
+    }
 
-    struct StackEntry {
-        Type type;
-        LitId literal;
-    };
+    // Index of the first literal of level, the decision for levels above 0
+    // that have one.
+    inline std::size_t level_start(std::uint32_t level) const {
+        return level == 0 ? 0 : level_starts[level - 1];
+    }
 
-    using StackType = std::vector<Assignment>;
+    // Opens a decision level, the next literal pushed is its decision.
+    inline void new_level() {
+        level_starts.push_back(static_cast<std::uint32_t>(top));
+    }
 
-    explicit AssignmentStack(VariableCache& variables) : variables(variables) {
-        stack.reserve(variables.variable_count());
+    // Whether literals are assigned but not yet propagated.
+    inline bool pending() const {
+        return head < top;
     }
 
-    const StackType::iterator begin() const {
-        return std::begin(stack);
+    inline std::size_t propagated() const {
+        return head;
     }
 
-    const StackType::iterator end() const {
-        return std::end(stack);
+    // The next literal to propagate.
+    inline LitId next() {
+        return literals[head++];
     }
 
-    bool assign(LitId lit) {
-        if constexpr (Debug()) {
-            if (variables.lit_val(lit) != Value::UNASSIGNED) {
-                std::stringstream str;
-                str << "BRANCH: " << lit << " but already assigned.";
-                Error(str);
+    // Drops all levels above level and calls unassign for every literal on
+    // them, in trail order. Literals for which unassign returns false were
+    // assigned out of order at level or below and stay on the trail, in
+    // order, where they are queued to be propagated again.
+    template <typename Unassign>
+    inline void backjump(std::uint32_t level, Unassign&& unassign) {
+        if (level >= this->level()) {
+            return;
+        }
+        std::size_t start = level_starts[level];
+        std::size_t kept = start;
+        for (std::size_t i = start; i < top; i++) {
+            if (!unassign(literals[i])) {
+                literals[kept++] = literals[i];
             }
         }
-        stack.emplace_back(StackEntry{Type::BRANCHED, lit});
-        assign_literal(variables, LitId);
-
-        if(!unit_prop()) {
-            return false;
+        top = kept;
+        if (head > start) {
+            head = start;
         }
-        return true;
+        level_starts.resize(level);
     }
 
-    bool backtrack(VariableCache& variables) {
-        unit_queue.clear();
+private:
 
-        if constexpr (Debug() && stack.empty()) {
-            return Error("Called backtrack on already empty stack");
-        }
-        for (;;) {
-            auto &top = stack.back();
-            if (top.type == AssignmentType::BRANCHED) {
-                return true;
-            }
-            unassign_literal(Vtop.literal);
-            stack.pop_back();
+    std::vector<LitId> literals;
 
-            if (stack.empty()) {
-                return false;
-            }
-        }
-    }
+    std::size_t top = 0;
 
-    bool negate_top() {
-        auto& top = stack.back();
-        negate_literal(top.literal);
-        top.type = AssignmentType::FORCED;
-        top.literal = -top.literal;
-    
-        return unit_prop();
-    }
+    std::size_t head = 0;
+
+    std::vector<std::uint32_t> level_starts;
 
-    void sanitize(const ClauseCache& clauses) const;
 };
 
-}  // NimmerSAT
\ No newline at end of file
+}  // namespace NimmerSAT
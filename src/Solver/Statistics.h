@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string_view>
+
+#include "NSatUtility.h"
+
+namespace NimmerSAT {
+
+// Counters of the search. The solver only updates them if Stats(), so a
+// NIMMERSAT_NO_STATS build does not pay for them in the hot path.
+struct SearchStatistics {
+    std::uint64_t decisions = 0;
+    std::uint64_t propagations = 0;
+    std::uint64_t conflicts = 0;
+    std::uint64_t restarts = 0;
+    std::uint64_t learnt_clauses = 0;
+    std::uint64_t deleted_clauses = 0;
+    std::uint64_t reductions = 0;
+    std::uint64_t inprocessings = 0;
+    std::uint64_t chronological_backtracks = 0;
+    std::uint64_t xor_implications = 0;
+    std::uint64_t xor_conflicts = 0;
+
+    inline SearchStatistics& operator+=(const SearchStatistics& other) {
+        decisions += other.decisions;
+        propagations += other.propagations;
+        conflicts += other.conflicts;
+        restarts += other.restarts;
+        learnt_clauses += other.learnt_clauses;
+        deleted_clauses += other.deleted_clauses;
+        reductions += other.reductions;
+        inprocessings += other.inprocessings;
+        chronological_backtracks += other.chronological_backtracks;
+        xor_implications += other.xor_implications;
+        xor_conflicts += other.xor_conflicts;
+        return *this;
+    }
+};
+
+// Wall clock seconds spent in the phases of a run.
+struct PhaseTimes {
+    double parse = 0.0;
+    double preprocess = 0.0;
+    double search = 0.0;
+};
+
+class Stopwatch final {
+public:
+
+    inline double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+};
+
+inline double PerSecond(std::uint64_t count, double seconds) {
+    return seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+}
+
+// One line of a table, preceded by its header on the first call.
+inline void PrintProgress(std::ostream& out, const SearchStatistics& statistics, double seconds, bool header) {
+    if (header) {
+        out << "c " << std::setw(9) << "seconds" << std::setw(12) << "conflicts"
+            << std::setw(12) << "decisions" << std::setw(12) << "props/s"
+            << std::setw(10) << "restarts" << std::setw(12) << "learnt"
+            << std::setw(12) << "deleted" << std::endl;
+    }
+    out << "c " << std::setw(9) << std::fixed << std::setprecision(1) << seconds
+        << std::setw(12) << statistics.conflicts << std::setw(12) << statistics.decisions
+        << std::setw(12) << std::setprecision(0) << PerSecond(statistics.propagations, seconds)
+        << std::setw(10) << statistics.restarts << std::setw(12) << statistics.learnt_clauses
+        << std::setw(12) << statistics.deleted_clauses << std::endl;
+}
+
+// Summary as comment lines in the style of the competition output format.
+inline void PrintSummary(std::ostream& out, const SearchStatistics& statistics, const PhaseTimes& times) {
+    auto line = [&](std::string_view name, std::uint64_t count) {
+        out << "c " << std::left << std::setw(16) << name << std::right << std::setw(14) << count
+            << std::setw(16) << std::fixed << std::setprecision(1)
+            << PerSecond(count, times.search) << " per second" << std::endl;
+    };
+    auto time = [&](std::string_view name, double seconds) {
+        out << "c " << std::left << std::setw(16) << name << std::right << std::setw(14)
+            << std::fixed << std::setprecision(3) << seconds << " seconds" << std::endl;
+    };
+    time("parse", times.parse);
+    time("preprocess", times.preprocess);
+    time("search", times.search);
+    line("decisions", statistics.decisions);
+    line("propagations", statistics.propagations);
+    line("conflicts", statistics.conflicts);
+    line("restarts", statistics.restarts);
+    line("learnt clauses", statistics.learnt_clauses);
+    line("deleted clauses", statistics.deleted_clauses);
+    line("reductions", statistics.reductions);
+    line("inprocessings", statistics.inprocessings);
+    line("chrono backtrack", statistics.chronological_backtracks);
+    line("xor implications", statistics.xor_implications);
+    line("xor conflicts", statistics.xor_conflicts);
+}
+
+inline void PrintSummaryJson(std::ostream& out, const SearchStatistics& statistics, const PhaseTimes& times) {
+    out << std::fixed << std::setprecision(6)
+        << "{\"times\": {\"parse\": " << times.parse
+        << ", \"preprocess\": " << times.preprocess
+        << ", \"search\": " << times.search << "}"
+        << ", \"decisions\": " << statistics.decisions
+        << ", \"propagations\": " << statistics.propagations
+        << ", \"conflicts\": " << statistics.conflicts
+        << ", \"restarts\": " << statistics.restarts
+        << ", \"learnt_clauses\": " << statistics.learnt_clauses
+        << ", \"deleted_clauses\": " << statistics.deleted_clauses
+        << ", \"reductions\": " << statistics.reductions
+        << ", \"inprocessings\": " << statistics.inprocessings
+        << ", \"chronological_backtracks\": " << statistics.chronological_backtracks
+        << ", \"xor_implications\": " << statistics.xor_implications
+        << ", \"xor_conflicts\": " << statistics.xor_conflicts << "}" << std::endl;
+}
+
+}  // namespace NimmerSAT
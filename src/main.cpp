@@ -1,39 +1,369 @@
 #include <iostream>
+#include <memory>
+#include <string_view>
+#include <cstdlib>
+#include <limits>
+#include <thread>
+#include <vector>
 
+#include <unistd.h>
+
+#include "Batch/Batch.h"
 #include "Dimacs/Dimacs.h"
 #include "Formula/FormulaCache.h"
 #include "Formula/VariableCache.h"
+#include "Preprocess/Preprocessor.h"
+#include "Proof/Proof.h"
 #include "Solver/Assign.h"
+#include "Solver/Cube.h"
+#include "Solver/Policy.h"
+#include "Solver/Portfolio.h"
+#include "Solver/Statistics.h"
+
+enum class StatisticsOutput {
+    NONE,
+    LINES,   // Progress and summary as comment lines on stderr
+    JSON     // Progress lines and a JSON summary on stderr
+};
+
+void PrintHelp() {
+    std::cout <<
+        "Usage: NimmerSAT [OPTIONS] FILE\n"
+        "       NimmerSAT --batch [--batch-socket=PATH] [OPTIONS] [FILES...]\n"
+        "\n"
+        "Search:\n"
+        "  --mode=cdcl|cube|sls          CDCL search (default), cube and conquer or local search only\n"
+        "  --decision=vsids|scan         Decision heuristic\n"
+        "  --restart=glucose|luby|none   Restart policy\n"
+        "  --chrono=N                    Backtrack one level for jumps over more than N levels\n"
+        "  --policy=fixed|runtime        Run a solver compiled for the options or check them at runtime\n"
+        "  --no-phase-saving  --no-inprocess  --no-preprocess  --no-local-search  --no-gauss\n"
+        "  --preprocess-budget=N  --xor-size=N  --sls-flips=N  --cube-depth=N  --cube-conflicts=N\n"
+        "\n"
+        "Parallel:\n"
+        "  --threads=N                   Portfolio of N solvers sharing learnt clauses. Every solver\n"
+        "                                holds its own copy of the preprocessed formula's clause arena,\n"
+        "                                so the memory for the formula grows N times\n"
+        "\n"
+        "Limits (sequential CDCL only):\n"
+        "  --conflict-budget=N  --propagation-budget=N  --time-limit=SECONDS  --memory-limit=MB\n"
+        "\n"
+        "Output:\n"
+        "  --proof=FILE  --proof-format=text|binary  --stats[=lines|json]  --help"
+        << std::endl;
+}
 
 int main(int argc, char* argv[]) {
 
-    if (argc <= 1) {
+    NimmerSAT::SolverOptions options;
+    NimmerSAT::PreprocessorOptions preprocessor_options;
+    NimmerSAT::CubeOptions cube_options;
+    bool cube_and_conquer = false;
+    bool local_search_only = false;
+    std::uint64_t local_search_flips = std::numeric_limits<std::uint64_t>::max();
+    StatisticsOutput statistics_output = StatisticsOutput::NONE;
+    const char* proof_path = nullptr;
+    NimmerSAT::ProofFormat proof_format = NimmerSAT::ProofFormat::TEXT;
+    NimmerSAT::SolveBudget budget;
+    bool budgeted = false;
+    std::uint32_t threads = 1;
+    bool threads_given = false;
+    bool batch = false;
+    const char* socket_path = nullptr;
+    std::vector<const char*> paths;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg(argv[i]);
+        if (arg == "--help") {
+            PrintHelp();
+            return 0;
+        } else if (arg == "--decision=scan") {
+            options.decision = NimmerSAT::DecisionHeuristic::SCAN;
+        } else if (arg == "--decision=vsids") {
+            options.decision = NimmerSAT::DecisionHeuristic::VSIDS;
+        } else if (arg == "--restart=none") {
+            options.restart = NimmerSAT::RestartPolicy::NONE;
+        } else if (arg == "--restart=luby") {
+            options.restart = NimmerSAT::RestartPolicy::LUBY;
+        } else if (arg == "--restart=glucose") {
+            options.restart = NimmerSAT::RestartPolicy::GLUCOSE;
+        } else if (arg.starts_with("--chrono=")) {
+            options.chrono_levels = static_cast<std::uint32_t>(std::strtoul(argv[i] + arg.find('=') + 1, nullptr, 10));
+        } else if (arg == "--no-phase-saving") {
+            options.phase_saving = false;
+        } else if (arg == "--policy=fixed") {
+            options.fixed_policy = true;
+        } else if (arg == "--policy=runtime") {
+            options.fixed_policy = false;
+        } else if (arg == "--no-inprocess") {
+            options.inprocessing = false;
+        } else if (arg == "--no-preprocess") {
+            preprocessor_options.enabled = false;
+        } else if (arg.starts_with("--preprocess-budget=")) {
+            preprocessor_options.step_budget = std::strtoull(argv[i] + arg.find('=') + 1, nullptr, 10);
+        } else if (arg == "--no-local-search") {
+            options.local_search = false;
+        } else if (arg == "--no-gauss") {
+            options.gaussian_elimination = false;
+        } else if (arg.starts_with("--xor-size=")) {
+            options.xor_max_size = static_cast<std::uint32_t>(std::strtoul(argv[i] + arg.find('=') + 1, nullptr, 10));
+        } else if (arg == "--mode=cdcl") {
+            cube_and_conquer = false;
+            local_search_only = false;
+        } else if (arg == "--mode=cube") {
+            cube_and_conquer = true;
+            local_search_only = false;
+        } else if (arg == "--mode=sls") {
+            cube_and_conquer = false;
+            local_search_only = true;
+        } else if (arg.starts_with("--sls-flips=")) {
+            local_search_flips = std::strtoull(argv[i] + arg.find('=') + 1, nullptr, 10);
+        } else if (arg.starts_with("--cube-depth=")) {
+            cube_options.depth = static_cast<std::uint32_t>(std::strtoul(argv[i] + arg.find('=') + 1, nullptr, 10));
+        } else if (arg.starts_with("--cube-conflicts=")) {
+            cube_options.conflict_budget = std::strtoull(argv[i] + arg.find('=') + 1, nullptr, 10);
+        } else if (arg == "--stats" || arg == "--stats=lines") {
+            statistics_output = StatisticsOutput::LINES;
+        } else if (arg == "--stats=json") {
+            statistics_output = StatisticsOutput::JSON;
+        } else if (arg.starts_with("--proof=")) {
+            proof_path = argv[i] + arg.find('=') + 1;
+        } else if (arg == "--proof-format=text") {
+            proof_format = NimmerSAT::ProofFormat::TEXT;
+        } else if (arg == "--proof-format=binary") {
+            proof_format = NimmerSAT::ProofFormat::BINARY;
+        } else if (arg.starts_with("--threads=")) {
+            threads = static_cast<std::uint32_t>(std::strtoul(argv[i] + arg.find('=') + 1, nullptr, 10));
+            if (threads == 0) {
+                std::cout << "Thread count must be positive." << std::endl;
+                return -1;
+            }
+            threads_given = true;
+        } else if (arg.starts_with("--conflict-budget=")) {
+            budget.conflicts = std::strtoull(argv[i] + arg.find('=') + 1, nullptr, 10);
+            budgeted = true;
+        } else if (arg.starts_with("--propagation-budget=")) {
+            budget.propagations = std::strtoull(argv[i] + arg.find('=') + 1, nullptr, 10);
+            budgeted = true;
+        } else if (arg.starts_with("--time-limit=")) {
+            budget.seconds = std::strtod(argv[i] + arg.find('=') + 1, nullptr);
+            budgeted = true;
+        } else if (arg.starts_with("--memory-limit=")) {
+            budget.memory_bytes = std::strtoull(argv[i] + arg.find('=') + 1, nullptr, 10) << 20;
+            budgeted = true;
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg.starts_with("--batch-socket=")) {
+            socket_path = argv[i] + arg.find('=') + 1;
+        } else if (arg.starts_with("--")) {
+            std::cout << "Unknown option " << arg << std::endl;
+            return -1;
+        } else {
+            path = argv[i];
+            paths.push_back(argv[i]);
+        }
+    }
+
+    // In batch mode every worker thread runs a sequential solver on one
+    // formula at a time. Without files the jobs are read from stdin.
+    if (batch || socket_path != nullptr) {
+        if (cube_and_conquer || local_search_only || proof_path != nullptr ||
+            statistics_output != StatisticsOutput::NONE) {
+            std::cout << "Batch mode only runs the CDCL solver, without proofs or statistics." << std::endl;
+            return -1;
+        }
+        std::uint32_t workers = threads_given ? threads : std::max(1u, std::thread::hardware_concurrency());
+        NimmerSAT::BatchSolver batch_solver(options, preprocessor_options, budget, workers);
+        if (socket_path != nullptr) {
+            NimmerSAT::ServeJobStreams(socket_path, batch_solver);
+            std::cerr << "c cannot serve on " << socket_path << std::endl;
+            return 1;
+        }
+
+        auto output = std::make_shared<NimmerSAT::ResultStream>(STDOUT_FILENO, false);
+        bool complete = true;
+        if (paths.empty()) {
+            complete = NimmerSAT::ReadJobStream(STDIN_FILENO, batch_solver, output);
+        }
+        for (const char* job_path : paths) {
+            batch_solver.submit(NimmerSAT::BatchJob{job_path, job_path, {}, output});
+        }
+        batch_solver.finish();
+        return complete ? 0 : 1;
+    }
+
+    if (path == nullptr) {
         std::cout << "Please specify an argument." << std::endl;
         return -1;
     }
+    if (statistics_output != StatisticsOutput::NONE && !NimmerSAT::Stats()) {
+        std::cout << "Statistics are disabled in this build." << std::endl;
+        return -1;
+    }
 
-    auto dimacs = ReadDimacsFromFile(argv[1]);
+    if (budgeted && (cube_and_conquer || local_search_only || threads > 1)) {
+        std::cout << "Budgets are only supported by the sequential CDCL solver." << std::endl;
+        return -1;
+    }
+
+    // Lemmas of a portfolio or of cubes are not implied by the clauses of
+    // any single solver, so only the sequential search writes proofs.
+    std::unique_ptr<NimmerSAT::ProofWriter> proof;
+    if (proof_path != nullptr) {
+        if (cube_and_conquer || threads > 1) {
+            std::cout << "Proofs are only supported with a single thread." << std::endl;
+            return -1;
+        }
+        proof = std::make_unique<NimmerSAT::ProofWriter>(proof_path, proof_format);
+        if (!proof->is_open()) {
+            std::cout << "Cannot open " << proof_path << std::endl;
+            return 1;
+        }
+    }
+    auto finish_proof = [&] {
+        if (proof && !proof->close()) {
+            std::cerr << "c writing the proof failed" << std::endl;
+        }
+    };
+
+    NimmerSAT::PhaseTimes times;
+    auto report = [&](const NimmerSAT::SearchStatistics& statistics) {
+        if (statistics_output == StatisticsOutput::LINES) {
+            NimmerSAT::PrintSummary(std::cerr, statistics, times);
+        } else if (statistics_output == StatisticsOutput::JSON) {
+            NimmerSAT::PrintSummaryJson(std::cerr, statistics, times);
+        }
+    };
+
+    NimmerSAT::Stopwatch parse_time;
+    auto dimacs = ReadDimacsFromFile(path);
+    times.parse = parse_time.seconds();
+    if (!dimacs.error.empty()) {
+        std::cout << dimacs.error << std::endl;
+        return 1;
+    }
 
     /*
-    for(auto& clause : dimacs.clauses) {
-        for (auto literal : clause.literals) {
-            std::cout << literal << ' ';
+    for(auto clause : dimacs.clauses) {
+        for (auto literal : dimacs.clauses[clause]) {
+            std::cout << NimmerSAT::LitToDimacs(literal) << ' ';
         }
         std::cout << '\n';
     }
     std::cout << std::endl;
     */
 
-    if (dimacs.variable_count == 0 || dimacs.clauses.size() == 0) {
-        std::cout << "Invalid path. Formula is empty." << std::endl;
+    if (dimacs.clauses.size() == 0) {
+        std::cout << "Formula is empty." << std::endl;
         return 1;
     }
 
-    NimmerSAT::Solver solver(dimacs.variable_count, std::move(dimacs.clauses));
-    if (solver.solve()){
-        std::cout << "S" << std::endl;
-        solver.print();
-    } else {
+    NimmerSAT::Stopwatch preprocess_time;
+    NimmerSAT::Preprocessor preprocessor(dimacs.variable_count, std::move(dimacs.clauses), preprocessor_options);
+    preprocessor.set_proof(proof.get());
+    bool consistent = preprocessor.run();
+    times.preprocess = preprocess_time.seconds();
+    if (!consistent) {
+        finish_proof();
         std::cout << "U" << std::endl;
+        report({});
+        return 0;
+    }
+
+    // Local search alone never proves unsatisfiability, it gives up after
+    // the number of flips given, if any. It does not use Gaussian
+    // elimination.
+    if (local_search_only) {
+        NimmerSAT::WithPolicy(options, proof != nullptr, false, [&](auto policy) {
+            NimmerSAT::BasicSolver<decltype(policy)> solver(dimacs.variable_count, preprocessor.take_clauses(),
+                                                            options);
+            solver.set_proof(proof.get());
+            NimmerSAT::Stopwatch search_time;
+            NimmerSAT::SolveResult result = solver.solve_local(local_search_flips);
+            times.search = search_time.seconds();
+            finish_proof();
+            if (result == NimmerSAT::SolveResult::SATISFIABLE) {
+                std::cout << "S" << std::endl;
+                solver.extend_model(preprocessor.reconstruction());
+                solver.print();
+            } else if (result == NimmerSAT::SolveResult::UNSATISFIABLE) {
+                std::cout << "U" << std::endl;
+            } else {
+                std::cout << "UNKNOWN" << std::endl;
+            }
+            report(solver.statistics());
+        });
+        return 0;
     }
+
+    if (cube_and_conquer) {
+        NimmerSAT::ClauseCache formula = preprocessor.take_clauses();
+        NimmerSAT::CubeAndConquer solver(dimacs.variable_count, formula, options, threads, cube_options);
+        NimmerSAT::Stopwatch search_time;
+        NimmerSAT::SolveResult result = solver.solve();
+        times.search = search_time.seconds();
+        if (result == NimmerSAT::SolveResult::SATISFIABLE) {
+            std::cout << "S" << std::endl;
+            solver.winner().extend_model(preprocessor.reconstruction());
+            solver.winner().print();
+        } else {
+            std::cout << "U" << std::endl;
+        }
+        report(solver.statistics());
+        return 0;
+    }
+
+    if (threads > 1) {
+        NimmerSAT::ClauseCache formula = preprocessor.take_clauses();
+        NimmerSAT::Portfolio portfolio(dimacs.variable_count, std::move(formula), options, threads);
+        NimmerSAT::Stopwatch search_time;
+        NimmerSAT::SolveResult result = portfolio.solve();
+        times.search = search_time.seconds();
+        if (result == NimmerSAT::SolveResult::SATISFIABLE) {
+            std::cout << "S" << std::endl;
+            portfolio.extend_model(preprocessor.reconstruction());
+            portfolio.print();
+        } else {
+            std::cout << "U" << std::endl;
+        }
+        report(portfolio.statistics());
+        return 0;
+    }
+
+    // The hot paths are compiled for the decision heuristic, restarts,
+    // phase saving, proof logging and Gaussian elimination of the common
+    // configurations, see Policy.h. Any other configuration reads them from
+    // the options.
+    NimmerSAT::ClauseCache clauses = preprocessor.take_clauses();
+    bool xors = options.gaussian_elimination && !NimmerSAT::FindXors(clauses, options.xor_max_size).empty();
+    NimmerSAT::WithPolicy(options, proof != nullptr, xors, [&](auto policy) {
+        NimmerSAT::BasicSolver<decltype(policy)> solver(dimacs.variable_count, std::move(clauses), options);
+        solver.set_proof(proof.get());
+        NimmerSAT::Stopwatch search_time;
+        if (statistics_output != StatisticsOutput::NONE) {
+            // A progress line at most every second, checked every few conflicts.
+            double last_progress = 0.0;
+            solver.set_progress_callback(1024, [&](const NimmerSAT::SearchStatistics& statistics) {
+                double seconds = search_time.seconds();
+                if (seconds >= last_progress + 1.0) {
+                    NimmerSAT::PrintProgress(std::cerr, statistics, seconds, last_progress == 0.0);
+                    last_progress = seconds;
+                }
+            });
+        }
+        solver.set_budget(budget);
+        NimmerSAT::SolveResult result = solver.solve();
+        times.search = search_time.seconds();
+        finish_proof();
+        if (result == NimmerSAT::SolveResult::SATISFIABLE) {
+            std::cout << "S" << std::endl;
+            solver.extend_model(preprocessor.reconstruction());
+            solver.print();
+        } else if (result == NimmerSAT::SolveResult::UNSATISFIABLE) {
+            std::cout << "U" << std::endl;
+        } else {
+            std::cout << "UNKNOWN" << std::endl;
+        }
+        report(solver.statistics());
+    });
 }
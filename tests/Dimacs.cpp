@@ -0,0 +1,200 @@
+// Parser test: reads well formed and malformed DIMACS files, plain and
+// compressed, through ReadDimacsFromFile and checks the clauses read or the
+// error reported for each of them.
+//
+//   nimmersat_dimacs_test
+//
+// Compressed inputs are written by the gzip, xz and bzip2 tools, and a tool
+// missing from PATH skips its cases. Exits with 1 if any case fails.
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Dimacs/Dimacs.h"
+#include "Solver/Assign.h"
+
+namespace {
+
+using namespace NimmerSAT;
+
+// Clauses as DIMACS literals, in the order of the input.
+using Formula = std::vector<std::vector<std::int32_t>>;
+
+class DimacsTest final {
+public:
+
+    explicit DimacsTest(std::filesystem::path directory) : directory(std::move(directory)) {
+    }
+
+    // Expects text to be read as formula over variable_count variables.
+    void accepts(std::string_view name, std::string_view text, std::uint32_t variable_count,
+                 const Formula& formula) {
+        check(name, read(write(text)), variable_count, formula);
+    }
+
+    // Expects reading text to fail with error.
+    void rejects(std::string_view name, std::string_view text, std::string_view error) {
+        check_error(name, read(write(text)), error);
+    }
+
+    // Expects text compressed by tool into a file with the given extension
+    // to be read as formula.
+    void accepts_compressed(std::string_view tool, std::string_view extension, std::string_view text,
+                            std::uint32_t variable_count, const Formula& formula) {
+        std::string name = std::string("compressed ") + std::string(tool);
+        auto plain = write(text);
+        auto packed = directory / (std::string(tool) + std::string(extension));
+        std::string command = std::string(tool) + " -c " + plain.string() + " > " + packed.string() + " 2>/dev/null";
+        if (std::system(command.c_str()) != 0) {
+            std::cout << "skipped " << name << ": " << tool << " not available" << std::endl;
+            return;
+        }
+        check(name, read(packed), variable_count, formula);
+    }
+
+    // Expects a file with the extension of tool but not in its format to
+    // fail with the error of a failed decompressor.
+    void rejects_corrupt(std::string_view tool, std::string_view extension) {
+        std::string name = std::string("corrupt ") + std::string(tool);
+        auto path = directory / ("corrupt" + std::string(extension));
+        std::ofstream(path) << "p cnf 1 1\n1 0\n";
+        std::string probe = std::string(tool) + " --help > /dev/null 2>&1";
+        if (std::system(probe.c_str()) != 0) {
+            std::cout << "skipped " << name << ": " << tool << " not available" << std::endl;
+            return;
+        }
+        check_error(name, read(path), std::string(tool) + " failed on " + path.string());
+    }
+
+    void rejects_missing() {
+        auto path = directory / "missing.cnf";
+        check_error("missing file", read(path), "Could not open " + path.string());
+    }
+
+    inline std::uint32_t failures() const {
+        return failure_count;
+    }
+
+private:
+
+    std::filesystem::path write(std::string_view text) {
+        auto path = directory / ("case" + std::to_string(case_count++) + ".cnf");
+        std::ofstream(path, std::ios::binary) << text;
+        return path;
+    }
+
+    static DimacsResult read(const std::filesystem::path& path) {
+        return ReadDimacsFromFile(path.c_str());
+    }
+
+    void fail(std::string_view name, std::string_view message) {
+        std::cerr << name << ": " << message << std::endl;
+        failure_count++;
+    }
+
+    void check(std::string_view name, const DimacsResult& result, std::uint32_t variable_count,
+               const Formula& formula) {
+        if (!result.error.empty()) {
+            return fail(name, "unexpected error '" + result.error + "'");
+        }
+        if (result.variable_count != variable_count) {
+            return fail(name, "read " + std::to_string(result.variable_count) + " variables");
+        }
+        Formula read;
+        for (ClauseId clause : result.clauses) {
+            auto &literals = read.emplace_back();
+            for (LitId lit : result.clauses[clause]) {
+                literals.push_back(LitToDimacs(lit));
+            }
+        }
+        if (read != formula) {
+            return fail(name, "read " + std::to_string(read.size()) + " clauses differing from the input");
+        }
+    }
+
+    void check_error(std::string_view name, const DimacsResult& result, std::string_view error) {
+        if (result.error != error) {
+            fail(name, "expected error '" + std::string(error) + "' but got '" + result.error + "'");
+        }
+    }
+
+    std::filesystem::path directory;
+
+    std::uint32_t case_count = 0;
+
+    std::uint32_t failure_count = 0;
+
+};
+
+// The empty clause is kept by the parser and refutes the formula, also when
+// the other clauses are satisfiable.
+bool CheckEmptyClause(const std::filesystem::path& directory) {
+    auto path = directory / "empty_clause.cnf";
+    std::ofstream(path) << "p cnf 1 2\n1 0\n0\n";
+    DimacsResult result = ReadDimacsFromFile(path.c_str());
+    if (!result.error.empty() || result.clauses.size() != 2) {
+        std::cerr << "empty clause: not read as a second clause" << std::endl;
+        return false;
+    }
+    Solver solver(result.variable_count, std::move(result.clauses));
+    if (solver.solve() != SolveResult::UNSATISFIABLE) {
+        std::cerr << "empty clause: formula not refuted" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    std::string pattern = (std::filesystem::temp_directory_path() / "nimmersat_dimacs_XXXXXX").string();
+    if (mkdtemp(pattern.data()) == nullptr) {
+        std::cerr << "Cannot create " << pattern << std::endl;
+        return 1;
+    }
+    std::filesystem::path directory(pattern);
+    DimacsTest test(directory);
+
+    const char* formula_text = "c comment\np cnf 3 2\n1 -2 0\n-3 2\n1 0\n";
+    Formula formula{{1, -2}, {-3, 2, 1}};
+    test.accepts("plain", formula_text, 3, formula);
+    test.accepts("largest variable count", "p cnf 1073741821 1\n1 0\n", MAX_VARIABLE, {{1}});
+
+    test.rejects("too many variables", "p cnf 1073741822 1\n1 0\n", "Line 1: Too many variables");
+    test.rejects("malformed problem line", "p cnf 3\n1 0\n",
+                 "Line 1: Expected 'p cnf <variables> <clauses>'");
+    test.rejects("wrong format", "p dnf 3 1\n1 0\n", "Line 1: Expected 'p cnf <variables> <clauses>'");
+    test.rejects("duplicate problem line", "p cnf 1 1\np cnf 1 1\n1 0\n", "Line 2: Duplicate problem line");
+    test.rejects("clauses beyond the input", "p cnf 3 1000\n1 0\n",
+                 "Line 1: Problem line declares more clauses than the input holds");
+    test.rejects("fewer clauses than declared", "p cnf 3 3\n1 0\n2 0\n",
+                 "Line 4: Problem line declares 3 clauses but 2 were found");
+    test.rejects("more clauses than declared", "p cnf 3 1\n1 0\n2 0\n",
+                 "Line 3: More clauses than declared in problem line");
+    test.rejects("missing 0", "p cnf 2 1\n1 2", "Line 2: Missing 0 after last clause");
+    test.rejects("variable out of range", "p cnf 2 1\n1 -3 0\n",
+                 "Line 2: Literal -3 exceeds declared variable count 2");
+    test.rejects("missing problem line", "c only a comment\n", "Line 2: Missing problem line");
+    test.rejects_missing();
+
+    test.accepts_compressed("gzip", ".cnf.gz", formula_text, 3, formula);
+    test.accepts_compressed("xz", ".cnf.xz", formula_text, 3, formula);
+    test.accepts_compressed("bzip2", ".cnf.bz2", formula_text, 3, formula);
+    test.rejects_corrupt("gzip", ".cnf.gz");
+    test.rejects_corrupt("xz", ".cnf.xz");
+    test.rejects_corrupt("bzip2", ".cnf.bz2");
+
+    bool empty_clause = CheckEmptyClause(directory);
+
+    std::filesystem::remove_all(directory);
+    if (test.failures() > 0 || !empty_clause) {
+        return 1;
+    }
+    std::cout << "All cases passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,411 @@
+// Randomized end to end test: solves small random formulas with the
+// preprocessor and the solver as the executable runs them, and checks every
+// answer against brute force. Models are checked on the original clauses
+// after model reconstruction, and with --proof every refutation is checked
+// as a DRAT proof of the original formula.
+//
+//   nimmersat_fuzz [--formulas=N] [--seed=N] [--chrono=N] [--no-gauss]
+//                  [--no-preprocess] [--no-inprocess] [--policy=runtime]
+//                  [--proof]
+//
+// Formulas have up to MAX_VARIABLES variables and mix short random clauses
+// with complete clause encodings of XOR constraints, so that Gaussian
+// elimination takes part, and units, so that the preprocessor finds some
+// formulas unsatisfiable on its own. Exits with 1 at the first wrong answer.
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Preprocess/Preprocessor.h"
+#include "Proof/Proof.h"
+#include "Solver/Assign.h"
+#include "Solver/Gauss.h"
+#include "Solver/Policy.h"
+
+namespace {
+
+using namespace NimmerSAT;
+
+constexpr std::uint32_t MAX_VARIABLES = 14;
+
+struct FuzzOptions {
+    std::uint64_t formulas = 500;
+    std::uint64_t seed = 1;
+    bool preprocess = true;
+    bool proof = false;
+    // A file of its own for every run, so that tests can run in parallel.
+    std::string proof_path;
+    SolverOptions solver;
+};
+
+// Clauses as DIMACS literals, variables from 1.
+using Formula = std::vector<std::vector<std::int32_t>>;
+
+Formula Generate(std::uint32_t variable_count, std::mt19937_64& random) {
+    auto below = [&](std::uint64_t bound) {
+        return static_cast<std::uint32_t>(random() % bound);
+    };
+    auto pick = [&](std::uint32_t count) {
+        std::vector<std::int32_t> variables(variable_count);
+        for (std::uint32_t var = 0; var < variable_count; var++) {
+            variables[var] = static_cast<std::int32_t>(var + 1);
+        }
+        std::shuffle(variables.begin(), variables.end(), random);
+        variables.resize(count);
+        return variables;
+    };
+
+    Formula formula;
+    std::uint32_t xor_count = below(2) == 0 ? 0 : 1 + below(variable_count / 2);
+    for (std::uint32_t i = 0; i < xor_count; i++) {
+        auto variables = pick(3 + below(std::min<std::uint32_t>(3, variable_count - 2)));
+        std::uint32_t parity = below(2);
+        for (std::uint32_t signs = 0; signs < (1u << variables.size()); signs++) {
+            if (static_cast<std::uint32_t>(std::popcount(signs)) % 2 == parity) {
+                auto &clause = formula.emplace_back();
+                for (std::size_t k = 0; k < variables.size(); k++) {
+                    clause.push_back((signs >> k) & 1 ? -variables[k] : variables[k]);
+                }
+            }
+        }
+    }
+    // Around the threshold of random 3-SAT, less where XORs constrain.
+    std::uint32_t clause_count = variable_count * (xor_count == 0 ? 3 : 1) + below(variable_count * 3 + 1);
+    for (std::uint32_t i = 0; i < clause_count; i++) {
+        std::uint32_t size = below(4) == 0 ? 2 : 3 + below(2);
+        auto &clause = formula.emplace_back(pick(std::min(size, variable_count)));
+        for (auto &lit : clause) {
+            lit = below(2) == 0 ? lit : -lit;
+        }
+    }
+    for (std::uint32_t i = below(3); i > 0; i--) {
+        formula.push_back({pick(1)[0] * (below(2) == 0 ? 1 : -1)});
+    }
+    std::shuffle(formula.begin(), formula.end(), random);
+    return formula;
+}
+
+bool Satisfies(const Formula& formula, auto&& value) {
+    return std::all_of(formula.begin(), formula.end(), [&](const auto &clause) {
+        return std::any_of(clause.begin(), clause.end(), value);
+    });
+}
+
+bool BruteForce(std::uint32_t variable_count, const Formula& formula) {
+    for (std::uint32_t assignment = 0; assignment < (1u << variable_count); assignment++) {
+        bool satisfied = Satisfies(formula, [&](std::int32_t lit) {
+            bool positive = (assignment >> (std::abs(lit) - 1)) & 1;
+            return positive == (lit > 0);
+        });
+        if (satisfied) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Forward DRAT checker by plain unit propagation over all active clauses,
+// fast enough for formulas of this size.
+class DratChecker final {
+public:
+
+    DratChecker(std::uint32_t variable_count, const Formula& formula) : values(variable_count + 1, 0) {
+        for (const auto &clause : formula) {
+            insert(clause);
+        }
+    }
+
+    // Returns an empty string if the proof derives the empty clause.
+    std::string check(const char* path) {
+        std::ifstream in(path);
+        std::string token;
+        std::vector<std::int32_t> clause;
+        bool deletion = false;
+        std::uint64_t line = 1;
+        while (in >> token) {
+            if (token == "d") {
+                deletion = true;
+                continue;
+            }
+            std::int32_t lit = std::stoi(token);
+            if (lit != 0) {
+                clause.push_back(lit);
+                continue;
+            }
+            if (deletion) {
+                if (!erase(clause)) {
+                    return "deleted clause missing at line " + std::to_string(line);
+                }
+            } else {
+                if (!implied(clause)) {
+                    return "lemma not RAT at line " + std::to_string(line);
+                }
+                if (clause.empty()) {
+                    return {};
+                }
+                insert(clause);
+            }
+            clause.clear();
+            deletion = false;
+            line++;
+        }
+        return "no empty clause";
+    }
+
+private:
+
+    static std::vector<std::int32_t> Normalize(std::vector<std::int32_t> clause) {
+        std::sort(clause.begin(), clause.end());
+        clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+        return clause;
+    }
+
+    void insert(const std::vector<std::int32_t>& clause) {
+        clauses[Normalize(clause)]++;
+    }
+
+    bool erase(const std::vector<std::int32_t>& clause) {
+        auto found = clauses.find(Normalize(clause));
+        if (found == clauses.end()) {
+            return false;
+        }
+        if (--found->second == 0) {
+            clauses.erase(found);
+        }
+        return true;
+    }
+
+    // Whether unit propagation after assigning the negation of clause
+    // conflicts.
+    bool rup(const std::vector<std::int32_t>& clause) {
+        std::fill(values.begin(), values.end(), 0);
+        for (std::int32_t lit : clause) {
+            if (values[std::abs(lit)] == (lit > 0 ? 1 : -1)) {
+                return true;
+            }
+            values[std::abs(lit)] = lit > 0 ? -1 : 1;
+        }
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const auto &[other, count] : clauses) {
+                std::int32_t unassigned = 0;
+                std::uint32_t open = 0;
+                bool satisfied = false;
+                for (std::int32_t lit : other) {
+                    std::int8_t value = values[std::abs(lit)];
+                    if (value == 0) {
+                        unassigned = lit;
+                        open++;
+                    } else if (value == (lit > 0 ? 1 : -1)) {
+                        satisfied = true;
+                        break;
+                    }
+                }
+                if (satisfied || open > 1) {
+                    continue;
+                }
+                if (open == 0) {
+                    return true;
+                }
+                values[std::abs(unassigned)] = unassigned > 0 ? 1 : -1;
+                changed = true;
+            }
+        }
+        return false;
+    }
+
+    // RUP, or RAT on the first literal.
+    bool implied(const std::vector<std::int32_t>& clause) {
+        if (rup(clause)) {
+            return true;
+        }
+        if (clause.empty()) {
+            return false;
+        }
+        std::int32_t pivot = clause[0];
+        std::vector<std::vector<std::int32_t>> partners;
+        for (const auto &[other, count] : clauses) {
+            if (std::find(other.begin(), other.end(), -pivot) != other.end()) {
+                partners.push_back(other);
+            }
+        }
+        for (const auto &other : partners) {
+            std::vector<std::int32_t> resolvent = clause;
+            for (std::int32_t lit : other) {
+                if (lit != -pivot) {
+                    resolvent.push_back(lit);
+                }
+            }
+            resolvent = Normalize(resolvent);
+            bool tautology = std::any_of(resolvent.begin(), resolvent.end(), [&](std::int32_t lit) {
+                return std::binary_search(resolvent.begin(), resolvent.end(), -lit);
+            });
+            if (!tautology && !rup(resolvent)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::map<std::vector<std::int32_t>, std::uint32_t> clauses;
+
+    std::vector<std::int8_t> values;
+
+};
+
+// Solves formula as the executable does. Returns an empty string if the
+// answer, the model and the proof are right.
+std::string Solve(std::uint32_t variable_count, const Formula& formula, bool expected,
+                  const FuzzOptions& options) {
+    ClauseCache clauses;
+    for (const auto &clause : formula) {
+        std::vector<LitId> literals;
+        for (std::int32_t lit : clause) {
+            literals.push_back(DimacsToLit(lit));
+        }
+        clauses.add(literals);
+    }
+
+    std::unique_ptr<ProofWriter> proof;
+    if (options.proof) {
+        proof = std::make_unique<ProofWriter>(options.proof_path.c_str(), ProofFormat::TEXT);
+    }
+    PreprocessorOptions preprocessor_options;
+    preprocessor_options.enabled = options.preprocess;
+    Preprocessor preprocessor(variable_count, std::move(clauses), preprocessor_options);
+    preprocessor.set_proof(proof.get());
+
+    SolveResult result = SolveResult::UNSATISFIABLE;
+    std::vector<Value> model;
+    if (preprocessor.run()) {
+        clauses = preprocessor.take_clauses();
+        bool xors = options.solver.gaussian_elimination &&
+            !FindXors(clauses, options.solver.xor_max_size).empty();
+        result = WithPolicy(options.solver, options.proof, xors, [&](auto policy) {
+            BasicSolver<decltype(policy)> solver(variable_count, std::move(clauses), options.solver);
+            solver.set_proof(proof.get());
+            SolveResult answer = solver.solve();
+            if (answer == SolveResult::SATISFIABLE) {
+                solver.extend_model(preprocessor.reconstruction());
+                for (VarId var = 1; var <= variable_count; var++) {
+                    model.push_back(solver.model_value(VarToLit(var, true)));
+                }
+            }
+            return answer;
+        });
+    }
+    if (proof && !proof->close()) {
+        return "writing the proof failed";
+    }
+
+    if (result == SolveResult::UNKNOWN) {
+        return "no answer";
+    }
+    if ((result == SolveResult::SATISFIABLE) != expected) {
+        return expected ? "refuted a satisfiable formula" : "satisfied an unsatisfiable formula";
+    }
+    if (result == SolveResult::SATISFIABLE) {
+        bool satisfied = Satisfies(formula, [&](std::int32_t lit) {
+            return model[std::abs(lit) - 1] == (lit > 0 ? Value::TRUE : Value::FALSE);
+        });
+        return satisfied ? std::string() : "model falsifies a clause";
+    }
+    if (options.proof) {
+        std::string error = DratChecker(variable_count, formula).check(options.proof_path.c_str());
+        return error.empty() ? error : "proof: " + error;
+    }
+    return {};
+}
+
+void Print(std::uint32_t variable_count, const Formula& formula) {
+    std::cerr << "p cnf " << variable_count << ' ' << formula.size() << '\n';
+    for (const auto &clause : formula) {
+        for (std::int32_t lit : clause) {
+            std::cerr << lit << ' ';
+        }
+        std::cerr << "0\n";
+    }
+}
+
+int Usage() {
+    std::cerr << "Usage: nimmersat_fuzz [--formulas=N] [--seed=N] [--chrono=N] [--no-gauss]\n"
+                 "                      [--no-preprocess] [--no-inprocess] [--policy=runtime]\n"
+                 "                      [--proof]" << std::endl;
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    FuzzOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg(argv[i]);
+        const char* value = argv[i] + arg.find('=') + 1;
+        if (arg.starts_with("--formulas=")) {
+            options.formulas = std::strtoull(value, nullptr, 10);
+        } else if (arg.starts_with("--seed=")) {
+            options.seed = std::strtoull(value, nullptr, 10);
+        } else if (arg.starts_with("--chrono=")) {
+            options.solver.chrono_levels = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--no-gauss") {
+            options.solver.gaussian_elimination = false;
+        } else if (arg == "--no-preprocess") {
+            options.preprocess = false;
+        } else if (arg == "--no-inprocess") {
+            options.solver.inprocessing = false;
+        } else if (arg == "--policy=runtime") {
+            options.solver.fixed_policy = false;
+        } else if (arg == "--proof") {
+            options.proof = true;
+        } else {
+            return Usage();
+        }
+    }
+
+    if (options.proof) {
+        std::string path = (std::filesystem::temp_directory_path() / "nimmersat_fuzz_XXXXXX").string();
+        int file = mkstemp(path.data());
+        if (file < 0) {
+            std::cerr << "Cannot create " << path << std::endl;
+            return 1;
+        }
+        close(file);
+        options.proof_path = path;
+    }
+
+    std::mt19937_64 random(options.seed);
+    std::uint64_t satisfiable = 0;
+    for (std::uint64_t i = 0; i < options.formulas; i++) {
+        std::uint32_t variable_count = 3 + static_cast<std::uint32_t>(random() % (MAX_VARIABLES - 2));
+        Formula formula = Generate(variable_count, random);
+        bool expected = BruteForce(variable_count, formula);
+        std::string error = Solve(variable_count, formula, expected, options);
+        if (!error.empty()) {
+            std::cerr << "Formula " << i << ": " << error << std::endl;
+            Print(variable_count, formula);
+            if (options.proof) {
+                std::cerr << "Proof kept in " << options.proof_path << std::endl;
+            }
+            return 1;
+        }
+        satisfiable += expected;
+    }
+    if (options.proof) {
+        std::filesystem::remove(options.proof_path);
+    }
+    std::cout << options.formulas << " formulas, " << satisfiable << " satisfiable" << std::endl;
+    return 0;
+}
@@ -0,0 +1,222 @@
+// Differential test of the IPASIR interface: runs random incremental
+// sequences of clauses, assumptions and solve calls and checks every result
+// of the API against brute force.
+//
+//   nimmersat_ipasir_test [--sequences=N] [--seed=N]
+//
+// After 10 every clause and every assumption must be true under ipasir_val.
+// After 20 the assumptions reported by ipasir_failed must be a subset of
+// the assumptions that is unsatisfiable together with the clauses on its
+// own. Every learnt clause passed to the learn callback must hold in all
+// models of the clauses added so far. Some calls are interrupted by the
+// terminate callback and may return 0, and the calls after them must still
+// be right. Exits with 1 at the first wrong result.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ipasir.h"
+
+namespace {
+
+constexpr std::uint32_t MAX_VARIABLES = 12;
+
+// Clauses as DIMACS literals.
+using Formula = std::vector<std::vector<int>>;
+
+bool Satisfies(const Formula& formula, std::uint32_t assignment) {
+    return std::all_of(formula.begin(), formula.end(), [&](const auto &clause) {
+        return std::any_of(clause.begin(), clause.end(), [&](int lit) {
+            return static_cast<bool>((assignment >> (std::abs(lit) - 1)) & 1) == (lit > 0);
+        });
+    });
+}
+
+// Whether formula has a model over variable_count variables in which all
+// units are true.
+bool BruteForce(std::uint32_t variable_count, const Formula& formula, const std::vector<int>& units) {
+    Formula extended = formula;
+    for (int lit : units) {
+        extended.push_back({lit});
+    }
+    for (std::uint32_t assignment = 0; assignment < (1u << variable_count); assignment++) {
+        if (Satisfies(extended, assignment)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct LearnCheck {
+    std::uint32_t variable_count = 0;
+    const Formula* formula = nullptr;
+    std::string error;
+};
+
+// Learnt clauses are implied by the formula, so no model falsifies one.
+void CheckLearnt(void* data, int* clause) {
+    auto &check = *static_cast<LearnCheck*>(data);
+    std::vector<int> literals;
+    for (int* lit = clause; *lit != 0; lit++) {
+        literals.push_back(*lit);
+    }
+    std::vector<int> negated;
+    for (int lit : literals) {
+        negated.push_back(-lit);
+    }
+    if (check.error.empty() && BruteForce(check.variable_count, *check.formula, negated)) {
+        std::stringstream str;
+        str << "learnt clause not implied:";
+        for (int lit : literals) {
+            str << ' ' << lit;
+        }
+        check.error = str.str();
+    }
+}
+
+// Stops the search at its first conflict.
+int TerminateAtOnce(void*) {
+    return 1;
+}
+
+std::string Describe(const Formula& formula, const std::vector<int>& assumptions) {
+    std::stringstream str;
+    str << "clauses:";
+    for (const auto &clause : formula) {
+        for (int lit : clause) {
+            str << ' ' << lit;
+        }
+        str << " 0";
+    }
+    str << "\nassumptions:";
+    for (int lit : assumptions) {
+        str << ' ' << lit;
+    }
+    return str.str();
+}
+
+// Runs one sequence, returning an empty string if all results are right.
+std::string RunSequence(std::mt19937_64& random) {
+    auto below = [&](std::uint64_t bound) {
+        return static_cast<std::uint32_t>(random() % bound);
+    };
+    std::uint32_t variable_count = 3 + below(MAX_VARIABLES - 2);
+    auto random_lit = [&] {
+        int var = static_cast<int>(1 + below(variable_count));
+        return below(2) == 0 ? var : -var;
+    };
+
+    Formula formula;
+    LearnCheck learn{variable_count, &formula, {}};
+    void* solver = ipasir_init();
+    ipasir_set_learn(solver, &learn, 8, CheckLearnt);
+
+    std::string error;
+    std::uint32_t rounds = 1 + below(8);
+    for (std::uint32_t round = 0; round < rounds && error.empty(); round++) {
+        for (std::uint32_t i = below(2 * variable_count + 1); i > 0; i--) {
+            auto &clause = formula.emplace_back();
+            for (std::uint32_t k = below(4) == 0 ? 1 + below(2) : 3; k > 0; k--) {
+                clause.push_back(random_lit());
+            }
+            for (int lit : clause) {
+                ipasir_add(solver, lit);
+            }
+            ipasir_add(solver, 0);
+        }
+
+        std::vector<int> assumptions;
+        for (std::uint32_t i = below(5); i > 0; i--) {
+            assumptions.push_back(random_lit());
+            ipasir_assume(solver, assumptions.back());
+        }
+        bool interrupt = below(8) == 0;
+        ipasir_set_terminate(solver, nullptr, interrupt ? TerminateAtOnce : nullptr);
+
+        int result = ipasir_solve(solver);
+        if (!learn.error.empty()) {
+            error = learn.error;
+            break;
+        }
+        bool expected = BruteForce(variable_count, formula, assumptions);
+        if (result == 0) {
+            if (!interrupt) {
+                error = "returned 0 without being interrupted";
+            }
+        } else if (result != 10 && result != 20) {
+            error = "returned " + std::to_string(result);
+        } else if ((result == 10) != expected) {
+            error = expected ? "refuted satisfiable assumptions" : "satisfied unsatisfiable assumptions";
+        } else if (result == 10) {
+            for (const auto &clause : formula) {
+                bool satisfied = std::any_of(clause.begin(), clause.end(), [&](int lit) {
+                    return ipasir_val(solver, lit) == lit;
+                });
+                if (!satisfied) {
+                    error = "model falsifies a clause";
+                }
+            }
+            for (int lit : assumptions) {
+                if (ipasir_val(solver, lit) != lit) {
+                    error = "model falsifies assumption " + std::to_string(lit);
+                }
+            }
+        } else {
+            std::vector<int> failed;
+            for (int lit : assumptions) {
+                if (ipasir_failed(solver, lit)) {
+                    failed.push_back(lit);
+                }
+            }
+            if (BruteForce(variable_count, formula, failed)) {
+                error = "failed assumptions are satisfiable with the clauses";
+            }
+        }
+        if (!error.empty()) {
+            error += "\n" + Describe(formula, assumptions);
+        }
+    }
+    ipasir_release(solver);
+    return error;
+}
+
+int Usage() {
+    std::cerr << "Usage: nimmersat_ipasir_test [--sequences=N] [--seed=N]" << std::endl;
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::uint64_t sequences = 2000;
+    std::uint64_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg(argv[i]);
+        const char* value = argv[i] + arg.find('=') + 1;
+        if (arg.starts_with("--sequences=")) {
+            sequences = std::strtoull(value, nullptr, 10);
+        } else if (arg.starts_with("--seed=")) {
+            seed = std::strtoull(value, nullptr, 10);
+        } else {
+            return Usage();
+        }
+    }
+
+    std::mt19937_64 random(seed);
+    for (std::uint64_t i = 0; i < sequences; i++) {
+        std::string error = RunSequence(random);
+        if (!error.empty()) {
+            std::cerr << "Sequence " << i << ": " << error << std::endl;
+            return 1;
+        }
+    }
+    std::cout << sequences << " sequences" << std::endl;
+    return 0;
+}